@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Boot as a set of init steps with declared dependencies.
+//
+//     const BootStep STEPS[] = {
+//         {"lcd", bootLcd, 0, BOOT_IN_TASK},
+//         {"routes", bootRoutes, BOOT_AFTER(STEP_WIFI), BOOT_ON_CALLER},
+//     };
+//     bootRun(STEPS, 2);
+//
+// bootRun() starts one FreeRTOS task per BOOT_IN_TASK step; each waits on
+// an event group for the steps it depends on, runs, records its start and
+// end time and the core it ran on, sets its own bit and deletes itself.
+// Independent steps overlap, so the LCD, pins and DFPlayer don't wait
+// for the Wi-Fi driver to start. BOOT_ON_CALLER steps run on the calling
+// task (loopTask) in table order, each once its dependencies are done,
+// for work that must know the loop task (memoryBegin) or share an object
+// with it. bootRun() returns when every step has finished, or after
+// BOOT_TIMEOUT_MS with the unfinished steps reported. A BOOT_ON_CALLER
+// step whose dependencies are still running then is not dropped: it is
+// left to bootPoll(), which the loop calls, and runs as soon as they
+// finish.
+//
+// Steps must not touch the same peripheral or object unless one depends
+// on the other; the web server doesn't serve until bootRun() returns.
+//
+// Every step, plus marks such as the first screen (bootMark()), goes into
+// a fixed timeline in microseconds since the app started (esp_timer; the
+// ROM and second-stage bootloader before that aren't counted).
+// bootPrint() writes it to Serial; GET /boot returns it in the Chrome
+// trace-event format (one thread per core, like /trace) for
+// ui.perfetto.dev, with firstScreenMs alongside.
+
+const int BOOT_MAX_STEPS = 16;
+const int BOOT_MAX_EVENTS = 24;
+const uint32_t BOOT_TASK_STACK = 4096;
+const unsigned long BOOT_TIMEOUT_MS = 10000;
+const unsigned long BOOT_FIRST_SCREEN_BUDGET_MS = 300;
+const char *const BOOT_MARK_FIRST_SCREEN = "firstScreen"; // bootPrint() checks it against the budget
+
+#define BOOT_AFTER(step) (1u << (step))
+
+enum BootWhere : uint8_t
+{
+    BOOT_IN_TASK,
+    BOOT_ON_CALLER,
+};
+
+struct BootStep
+{
+    const char *name;
+    void (*run)();
+    uint32_t after; // BOOT_AFTER() of every step (table index) that must finish first
+    BootWhere where;
+};
+
+struct BootEvent
+{
+    const char *name;
+    uint32_t startUs;
+    uint32_t endUs; // == startUs for a mark
+    uint8_t core;
+};
+
+// Runs the table; false when a step didn't finish within BOOT_TIMEOUT_MS.
+bool bootRun(const BootStep *steps, int count);
+
+// Runs the BOOT_ON_CALLER steps bootRun() deferred whose dependencies have
+// finished since. True when none are left; cheap to call every loop pass.
+bool bootPoll();
+
+// A point in time worth seeing on the timeline, e.g. BOOT_MARK_FIRST_SCREEN.
+void bootMark(const char *name);
+
+int bootEventCount();
+const BootEvent &bootEvent(int index);
+uint32_t bootMarkUs(const char *name); // 0 if never marked
+
+void bootPrint(Print &out);
+
+// Registers GET /boot.
+void bootBegin(WebServer &server);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Pointer-bump allocator over a caller-owned block.
+//
+// allocate() moves a cursor forward; nothing is freed individually and
+// reset() releases everything at once. Every block carries a small size
+// header so reallocate() can grow the most recent block in place (the
+// common case for ArduinoJson's string builder) or copy otherwise.
+//
+// A request that does not fit gets nullptr and bumps failures(); the arena
+// never falls back to the heap. No Arduino dependencies, so the host
+// benchmark (tools/arena_bench.cpp) measures this exact code.
+
+class BumpArena
+{
+public:
+    static const size_t ALIGN = alignof(max_align_t);
+
+    BumpArena(uint8_t *memory, size_t size) : memory_(memory), size_(size) { reset(); }
+
+    void *allocate(size_t size)
+    {
+        size_t need = ALIGN + roundUp(size);
+        if (need < size || need > size_ - used_)
+        {
+            failures_++;
+            return nullptr;
+        }
+        uint8_t *block = memory_ + used_;
+        *(size_t *)block = size;
+        last_ = block + ALIGN;
+        used_ += need;
+        if (used_ > peak_)
+        {
+            peak_ = used_;
+        }
+        return last_;
+    }
+
+    void *reallocate(void *ptr, size_t size)
+    {
+        if (!ptr)
+        {
+            return allocate(size);
+        }
+        size_t *header = (size_t *)((uint8_t *)ptr - ALIGN);
+        if (ptr == last_)
+        {
+            // Most recent block: move the cursor instead of copying.
+            size_t start = (uint8_t *)ptr - memory_;
+            size_t end = start + roundUp(size);
+            if (end >= start && end <= size_)
+            {
+                *header = size;
+                used_ = end;
+                if (used_ > peak_)
+                {
+                    peak_ = used_;
+                }
+                return ptr;
+            }
+            failures_++;
+            return nullptr;
+        }
+        void *moved = allocate(size);
+        if (moved)
+        {
+            memcpy(moved, ptr, *header < size ? *header : size);
+        }
+        return moved;
+    }
+
+    void reset()
+    {
+        used_ = 0;
+        last_ = nullptr;
+    }
+
+    size_t used() const { return used_; }
+    size_t peak() const { return peak_; }
+    size_t capacity() const { return size_; }
+    uint32_t failures() const { return failures_; }
+    void resetPeak() { peak_ = used_; }
+
+private:
+    static size_t roundUp(size_t size) { return (size + ALIGN - 1) & ~(ALIGN - 1); }
+
+    uint8_t *memory_;
+    size_t size_;
+    size_t used_ = 0;
+    size_t peak_ = 0;
+    uint32_t failures_ = 0;
+    void *last_ = nullptr;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "log_messages.h"
+
+// Deferred logging for the game's hot paths.
+//
+//     logDeferred<LOG_FINAL_SCORE>(score);
+//
+// The call stores the message id, the time and the raw arguments in a
+// lock-free ring (mpsc_ring.h) and returns; no formatting, no String, no
+// UART. A low-priority task on core 0 drains the ring every
+// LOG_DRAIN_INTERVAL_MS, formats each record from the message table
+// (log_messages.h) and writes it to Serial, so a full UART FIFO stalls
+// that task instead of the game loop on core 1. Lines carry the time they
+// were logged, not the time they were printed.
+//
+// Messages below SIMON_LOG_LEVEL are stripped at compile time: the call
+// compiles to nothing. The default keeps INFO and up; build with
+// -DSIMON_LOG_LEVEL=LOG_LEVEL_DEBUG for per-press and per-round lines.
+//
+// A full ring drops the message and counts it; the drain task reports the
+// count, and /metrics exports it. With -DSIMON_LOG_BINARY the task writes
+// checksummed binary frames instead of text, for tools/log_decode.cpp to
+// expand on the host.
+//
+// logBegin() only starts the drain task; messages logged before it (e.g.
+// from wifiBegin) wait in the ring.
+
+#ifndef SIMON_LOG_LEVEL
+#define SIMON_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+const int LOG_RING_SIZE = 128;
+const unsigned long LOG_DRAIN_INTERVAL_MS = 20;
+
+void logBegin();
+uint32_t logDropped();
+
+void logPush(LogId id, const uint32_t *args, uint8_t argc);
+
+template <LogId Id, class... Args>
+inline void logDeferred(Args... args)
+{
+    static_assert(sizeof...(Args) == LOG_MESSAGES[Id].argc, "argument count does not match the message format");
+    if constexpr (LOG_MESSAGES[Id].level >= SIMON_LOG_LEVEL)
+    {
+        const uint32_t words[LOG_MAX_ARGS + 1] = {logWord(args)...};
+        logPush(Id, words, sizeof...(Args));
+    }
+}
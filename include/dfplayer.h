@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// DFPlayer Mini serial frames, kept free of Arduino calls so the host
+// benchmarks encode exactly what the firmware sends.
+//
+// Frame: 7E FF 06 CMD 00 P1 P2 CHK_H CHK_L EF, where the checksum is the
+// two's complement of the sum of bytes 1..6.
+
+const uint8_t DFPLAYER_START_BYTE = 0x7E;
+const uint8_t DFPLAYER_VERSION_BYTE = 0xFF;
+const uint8_t DFPLAYER_COMMAND_LENGTH = 0x06;
+const uint8_t DFPLAYER_ACKNOWLEDGE = 0x00; // no reply requested
+const uint8_t DFPLAYER_END_BYTE = 0xEF;
+const size_t DFPLAYER_FRAME_SIZE = 10;
+
+const uint8_t DFPLAYER_SET_VOLUME = 0x06;
+const uint8_t DFPLAYER_PLAY_FOLDER_TRACK = 0x14; // folder in the top 4 bits, track 0..4095
+
+inline void dfplayerFrame(uint8_t *frame, uint8_t command, uint8_t par1, uint8_t par2)
+{
+    int16_t checksum = -(DFPLAYER_VERSION_BYTE + DFPLAYER_COMMAND_LENGTH + command + DFPLAYER_ACKNOWLEDGE + par1 + par2);
+    frame[0] = DFPLAYER_START_BYTE;
+    frame[1] = DFPLAYER_VERSION_BYTE;
+    frame[2] = DFPLAYER_COMMAND_LENGTH;
+    frame[3] = command;
+    frame[4] = DFPLAYER_ACKNOWLEDGE;
+    frame[5] = par1;
+    frame[6] = par2;
+    frame[7] = (uint8_t)(checksum >> 8);
+    frame[8] = (uint8_t)checksum;
+    frame[9] = DFPLAYER_END_BYTE;
+}
+
+inline void dfplayerPlayInFolder(uint8_t *frame, int folder, int track)
+{
+    dfplayerFrame(frame, DFPLAYER_PLAY_FOLDER_TRACK, folder * 16 + track / 256, track % 256);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Adaptive difficulty from the player's actual performance.
+//
+// The engine keeps running statistics on every press (reaction time mean and
+// variance, error rate) and every round (cleared or failed). After each
+// round it moves a difficulty level on a weighted staircase: up UP_STEP on a
+// clear, down UP_STEP * target / (1 - target) on a failure. That staircase
+// settles where the round success rate equals the target.
+//
+// The level indexes a tempo curve computed at compile time (step duration,
+// gap between steps, press feedback). A player who is both fast and
+// accurate at a high level gets two new steps per round instead of one.
+//
+// No Arduino dependencies, so the same engine runs in the host simulator.
+
+struct Tempo
+{
+    uint16_t stepMs;     // LED + sound on, per Simon step
+    uint16_t gapMs;      // dark gap between Simon steps
+    uint16_t feedbackMs; // LED flash after a correct press
+};
+
+const int DIFFICULTY_LEVELS = 32;
+const size_t DIFFICULTY_JSON_MAX = 320; // buffer size that always fits toJson()
+
+struct DifficultyState
+{
+    float level;           // 0 .. DIFFICULTY_LEVELS - 1
+    float targetSuccess;   // fraction of rounds the player should clear
+    float reactionMeanMs;  // EWMA of press reaction time
+    float reactionVarMs2;  // EWMA variance of press reaction time
+    float errorRate;       // EWMA of wrong presses
+    uint32_t presses;
+    uint32_t roundsCleared;
+    uint32_t roundsFailed;
+};
+
+class DifficultyEngine
+{
+public:
+    DifficultyEngine();
+
+    // Starts from the easiest tempo (the original 800 ms / 300 ms), keeps the target.
+    void reset();
+    void setTarget(float targetSuccess);
+
+    void recordPress(unsigned long reactionMs, bool correct);
+    void recordRound(bool cleared);
+
+    const Tempo &tempo() const;
+    int stepsPerRound() const;
+    const DifficultyState &state() const { return state_; }
+
+    // JSON snapshot for tuning (/difficulty).
+    size_t toJson(char *out, size_t size) const;
+
+private:
+    int currentLevel() const;
+
+    DifficultyState state_;
+};
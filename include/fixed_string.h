@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Heap-free text building for LCD lines, logs and small HTTP replies.
+//
+// Arduino String allocates on every concatenation; over a long uptime those
+// short-lived blocks fragment the heap until HTTPClient cannot get a large
+// enough one. FixedString keeps its characters inline (on the stack or in
+// a global), never allocates, and truncates instead of growing. truncated()
+// tells the caller if that happened.
+//
+// The integer helpers format without printf, so they are also cheap enough
+// for per-press paths.
+
+// Longest decimal long including the sign (64-bit on the host tools).
+const size_t INT_TEXT_MAX = 20;
+
+// Writes value in decimal to out (no terminator). out needs INT_TEXT_MAX bytes.
+inline size_t formatUnsigned(char *out, unsigned long value)
+{
+    char digits[INT_TEXT_MAX];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+inline size_t formatInt(char *out, long value)
+{
+    if (value >= 0)
+    {
+        return formatUnsigned(out, (unsigned long)value);
+    }
+    out[0] = '-';
+    return 1 + formatUnsigned(out + 1, 0ul - (unsigned long)value);
+}
+
+template <size_t Capacity>
+class FixedString
+{
+public:
+    FixedString() { clear(); }
+    explicit FixedString(const char *text)
+    {
+        clear();
+        append(text);
+    }
+
+    void clear()
+    {
+        length_ = 0;
+        truncated_ = false;
+        text_[0] = '\0';
+    }
+
+    FixedString &append(const char *text)
+    {
+        return append(text, strlen(text));
+    }
+
+    FixedString &append(const char *text, size_t length)
+    {
+        size_t room = Capacity - length_;
+        if (length > room)
+        {
+            length = room;
+            truncated_ = true;
+        }
+        memcpy(text_ + length_, text, length);
+        length_ += length;
+        text_[length_] = '\0';
+        return *this;
+    }
+
+    FixedString &append(char c) { return append(&c, 1); }
+
+    FixedString &append(long value)
+    {
+        char digits[INT_TEXT_MAX];
+        return append(digits, formatInt(digits, value));
+    }
+
+    FixedString &append(unsigned long value)
+    {
+        char digits[INT_TEXT_MAX];
+        return append(digits, formatUnsigned(digits, value));
+    }
+
+    FixedString &append(int value) { return append((long)value); }
+    FixedString &append(unsigned value) { return append((unsigned long)value); }
+
+    template <class T>
+    FixedString &operator+=(const T &value)
+    {
+        return append(value);
+    }
+
+    const char *c_str() const { return text_; }
+    size_t length() const { return length_; }
+    static constexpr size_t capacity() { return Capacity; }
+    bool truncated() const { return truncated_; }
+
+private:
+    char text_[Capacity + 1];
+    size_t length_;
+    bool truncated_;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "difficulty.h"
+#include "game_modes.h"
+#include "packed_sequence.h"
+#include "pcg32.h"
+
+// Hardware-free rules of one Simon game, shared by the firmware and the
+// host simulator (tools/simulator.cpp).
+//
+// The caller owns all timing and I/O: it asks the core to extend the
+// sequence, plays it back however it likes, then feeds presses in. All
+// mode-specific behaviour comes from the Mode policies at compile time.
+
+// --- storage-specific helpers, so the core works with either container ---
+
+template <size_t Capacity>
+void resetSequence(PackedSequence<Capacity> &sequence, uint32_t)
+{
+    sequence.clear();
+}
+
+inline void resetSequence(SeededSequence &sequence, uint32_t seed)
+{
+    sequence.reset(seed);
+}
+
+template <size_t Capacity>
+void appendStep(PackedSequence<Capacity> &sequence, Pcg32 &rng)
+{
+    sequence.push_back(rng.bounded(5));
+}
+
+inline void appendStep(SeededSequence &sequence, Pcg32 &)
+{
+    sequence.grow();
+}
+
+// Which generator turned a game's seed into its steps, sent with the score
+// so the backend knows how to regenerate the game: PCG32 bounded(5) draws
+// after reseed(seed) for PackedSequence, the (seed, i) hash for
+// SeededSequence. Bump a value if its generator ever changes.
+enum SequenceGenerator
+{
+    SEQUENCE_GEN_PCG32 = 1,
+    SEQUENCE_GEN_SEED_HASH = 2,
+};
+
+template <size_t Capacity>
+constexpr SequenceGenerator sequenceGenerator(const PackedSequence<Capacity> &)
+{
+    return SEQUENCE_GEN_PCG32;
+}
+
+constexpr SequenceGenerator sequenceGenerator(const SeededSequence &)
+{
+    return SEQUENCE_GEN_SEED_HASH;
+}
+
+template <class Mode, class Sequence>
+class GameCore
+{
+public:
+    GameCore(Sequence &sequence, Pcg32 &rng, DifficultyEngine &difficulty, size_t maxSteps)
+        : sequence_(sequence), rng_(rng), difficulty_(difficulty), maxSteps_(maxSteps)
+    {
+    }
+
+    void start(uint32_t seed)
+    {
+        rng_.reseed(seed);
+        resetSequence(sequence_, seed);
+        round_ = 0;
+    }
+
+    // Adds this round's new steps. Returns how many were added; 0 means the
+    // sequence is already at maxSteps (marathon complete).
+    int extend()
+    {
+        int steps = Mode::Extension::stepsPerRound(difficulty_);
+        size_t room = maxSteps_ - sequence_.size();
+        if ((size_t)steps > room)
+        {
+            steps = (int)room;
+        }
+        for (int n = 0; n < steps; n++)
+        {
+            appendStep(sequence_, rng_);
+        }
+        if (steps > 0)
+        {
+            round_++;
+        }
+        return steps;
+    }
+
+    size_t length() const { return sequence_.size(); }
+    // 1 in the first round; differs from length() once rounds add two steps
+    uint32_t round() const { return round_; }
+    const Sequence &sequence() const { return sequence_; }
+
+    uint8_t expected(size_t press) const
+    {
+        return sequence_[Mode::Order::index(press, sequence_.size())];
+    }
+
+    // Checks one press; a wrong press also closes the round as failed.
+    bool press(size_t index, uint8_t button, unsigned long reactionMs)
+    {
+        bool correct = button == expected(index);
+        difficulty_.recordPress(reactionMs, correct);
+        if (!correct)
+        {
+            difficulty_.recordRound(false);
+        }
+        return correct;
+    }
+
+    // Closes a cleared round and returns the points it earned.
+    int roundCleared()
+    {
+        difficulty_.recordRound(true);
+        return Mode::Scoring::roundPoints(sequence_.size());
+    }
+
+    bool expired(unsigned long now, unsigned long gameStartedAt, unsigned long promptedAt) const
+    {
+        return Mode::Timing::expired(now, gameStartedAt, promptedAt);
+    }
+
+    const Tempo &tempo() const { return difficulty_.tempo(); }
+
+private:
+    Sequence &sequence_;
+    Pcg32 &rng_;
+    DifficultyEngine &difficulty_;
+    size_t maxSteps_;
+    uint32_t round_ = 0;
+};
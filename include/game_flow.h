@@ -0,0 +1,175 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "difficulty.h"
+
+// What the player sees and hears during a game, and when: Simon's
+// playback, the input loop with its debounce and timeouts, and the pause
+// between rounds. The rules come from GameCore (game_core.h); every pin,
+// sound, screen and clock access goes through a Board, so the firmware
+// runs this on the cabinet (CabinetBoard in main.cpp) and the host tools
+// (golden timing, simulator, fuzzer) run the same code on a virtual clock
+// (tools/virtual_board.h).
+//
+// Board concept:
+//     unsigned long millis();  void delay(unsigned long ms);
+//     bool buttonDown(int &button)      a button is down right now (lowest index wins)
+//     bool buttonHeld(int button)
+//     void led(int button, bool on);  void sound(int button)  (starts it and returns)
+//     void showScore(const char *line2);  void lcd(const char *line1, const char *line2)
+//     void background()                 non-blocking housekeeping while waiting for input
+//     template <class Core> void onRoundStart(const Core &core, int added)
+//     void onStep(size_t index, uint8_t move)
+//     void onPress(int button, unsigned long reactionMs, bool correct)
+//     void onRoundCleared(int score);  void onGameEnd(GameEnd why)
+//     Scope                             constructed as Scope(FlowPhase, arg) around each phase
+
+// Every timing a player can feel is either here or in the difficulty
+// engine's Tempo; the golden timelines in tools/golden_timing/ pin them down.
+const unsigned long DEBOUNCE_MS = 150;        // after a press goes down, before waiting for release
+const unsigned long BUTTON_STUCK_MS = 5000;   // a press held this long is taken as released
+const unsigned long PRESS_ABANDON_MS = 60000; // nobody pressing mid-game: end it
+const unsigned long ROUND_PAUSE_MS = 1000;    // between a cleared round and the next playback
+const unsigned long MARATHON_DONE_MS = 2000;  // "Marathon done!" stays up this long
+
+enum FlowPhase : uint8_t
+{
+    FLOW_SIMON_TURN,
+    FLOW_PLAYER_TURN,
+    FLOW_PRESS,
+};
+
+enum GameEnd : uint8_t
+{
+    GAME_END_WRONG_PRESS,
+    GAME_END_TIME_UP,
+    GAME_END_ABANDONED,
+    GAME_END_MARATHON,
+};
+
+// One debounced press: waits out the bounce and the release (bounded by
+// BUTTON_STUCK_MS). downAt is when the press went down.
+template <class Board>
+bool readPress(Board &board, int &button, unsigned long &downAt)
+{
+    int down;
+    if (!board.buttonDown(down))
+    {
+        return false;
+    }
+    downAt = board.millis();
+    board.delay(DEBOUNCE_MS);
+    while (board.buttonHeld(down) && board.millis() - downAt < BUTTON_STUCK_MS)
+        ;
+    button = down;
+    return true;
+}
+
+// Simon adds this round's steps and plays the whole sequence back.
+// False when the marathon is complete.
+template <class Board, class Core>
+bool playSimonTurn(Board &board, Core &core)
+{
+    typename Board::Scope scope(FLOW_SIMON_TURN, 0);
+    int added = core.extend();
+    if (added == 0)
+    {
+        board.onGameEnd(GAME_END_MARATHON);
+        board.lcd("Marathon done!", "");
+        board.delay(MARATHON_DONE_MS);
+        return false;
+    }
+
+    board.onRoundStart(core, added);
+    board.showScore("Simon's Turn");
+
+    // Tempo comes from the difficulty engine, fixed for the whole playback
+    const Tempo &tempo = core.tempo();
+    size_t i = 0;
+    for (uint8_t move : core.sequence())
+    {
+        board.led(move, true);
+        board.onStep(i, move);
+        board.sound(move);
+        board.delay(tempo.stepMs);
+        board.led(move, false);
+        board.delay(tempo.gapMs);
+        i++;
+    }
+    return true;
+}
+
+// The player repeats the sequence in the mode's order. False ends the game.
+template <class Board, class Core>
+bool playPlayerTurn(Board &board, Core &core, unsigned long gameStartedAt, int &score)
+{
+    typename Board::Scope scope(FLOW_PLAYER_TURN, core.length());
+    board.showScore("Your Turn");
+
+    const size_t length = core.length();
+    unsigned long promptedAt = board.millis();
+    for (size_t index = 0; index < length;)
+    {
+        board.background();
+        if (core.expired(board.millis(), gameStartedAt, promptedAt))
+        {
+            board.onGameEnd(GAME_END_TIME_UP);
+            return false;
+        }
+        if (board.millis() - promptedAt > PRESS_ABANDON_MS)
+        {
+            board.onGameEnd(GAME_END_ABANDONED);
+            return false;
+        }
+        int button;
+        unsigned long downAt;
+        if (!readPress(board, button, downAt))
+        {
+            continue;
+        }
+
+        unsigned long reactionMs = downAt - promptedAt;
+        bool correct;
+        {
+            typename Board::Scope pressScope(FLOW_PRESS, button); // press handling only, not the debounce wait
+            correct = core.press(index, button, reactionMs);
+            board.onPress(button, reactionMs, correct);
+        }
+        if (!correct)
+        {
+            board.onGameEnd(GAME_END_WRONG_PRESS);
+            return false;
+        }
+
+        board.led(button, true);
+        board.sound(button);
+        board.delay(core.tempo().feedbackMs);
+        board.led(button, false);
+        index++;
+        promptedAt = board.millis();
+    }
+
+    score += core.roundCleared();
+    board.onRoundCleared(score);
+    return true;
+}
+
+// One whole game, rounds run in a loop instead of recursing. Returns the
+// number of rounds Simon got to play.
+template <class Board, class Core>
+uint32_t playRounds(Board &board, Core &core, int &score)
+{
+    unsigned long gameStartedAt = board.millis();
+    uint32_t rounds = 0;
+    while (playSimonTurn(board, core))
+    {
+        rounds++;
+        if (!playPlayerTurn(board, core, gameStartedAt, score))
+        {
+            break;
+        }
+        board.delay(ROUND_PAUSE_MS);
+    }
+    return rounds;
+}
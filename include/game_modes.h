@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include "difficulty.h"
+
+// Game modes as compile-time policy bundles.
+//
+// The game rules (GameCore<Mode> in game_core.h) are a template over one of
+// the GameMode<> aliases below, so every mode compiles to its own specialised
+// loop. Policies are static member functions: no flags and no virtual calls
+// end up on the input path.
+//
+// Policy concepts:
+//     Extension::stepsPerRound(difficulty)         new steps added each round
+//     Order::index(i, length)                      which stored step the i-th press must match
+//     Timing::expired(now, gameStartedAt, promptedAt)  true ends the game
+//     Scoring::roundPoints(length)                 points for clearing a round
+
+// --- sequence extension ---
+
+struct AdaptiveExtension
+{
+    static int stepsPerRound(const DifficultyEngine &difficulty) { return difficulty.stepsPerRound(); }
+};
+
+template <int Steps>
+struct FixedExtension
+{
+    static int stepsPerRound(const DifficultyEngine &) { return Steps; }
+};
+
+// --- expected input order ---
+
+struct ForwardOrder
+{
+    static size_t index(size_t press, size_t) { return press; }
+};
+
+struct ReverseOrder
+{
+    static size_t index(size_t press, size_t length) { return length - 1 - press; }
+};
+
+// --- timing rule ---
+
+struct Untimed
+{
+    static bool expired(unsigned long, unsigned long, unsigned long) { return false; }
+};
+
+// Whole game must fit in GameMs and no single press may take longer than PressMs.
+template <unsigned long GameMs, unsigned long PressMs>
+struct GameClock
+{
+    static bool expired(unsigned long now, unsigned long gameStartedAt, unsigned long promptedAt)
+    {
+        return now - gameStartedAt > GameMs || now - promptedAt > PressMs;
+    }
+};
+
+// --- scoring ---
+
+template <int Points>
+struct PerRoundScoring
+{
+    static int roundPoints(size_t) { return Points; }
+};
+
+// Longer rounds are worth more; rewards speed when the clock is running.
+struct LengthScoring
+{
+    static int roundPoints(size_t length) { return 10 * (int)length; }
+};
+
+template <class ExtensionPolicy, class OrderPolicy, class TimingPolicy, class ScoringPolicy>
+struct GameMode
+{
+    typedef ExtensionPolicy Extension;
+    typedef OrderPolicy Order;
+    typedef TimingPolicy Timing;
+    typedef ScoringPolicy Scoring;
+};
+
+typedef GameMode<AdaptiveExtension, ForwardOrder, Untimed, PerRoundScoring<10>> ClassicMode;
+typedef GameMode<AdaptiveExtension, ReverseOrder, Untimed, PerRoundScoring<10>> ReverseMode;
+typedef GameMode<AdaptiveExtension, ForwardOrder, GameClock<90000, 5000>, LengthScoring> TimeAttackMode;
+typedef GameMode<FixedExtension<2>, ForwardOrder, Untimed, PerRoundScoring<20>> DoubleStepMode;
+
+// Runtime id, only used by the menu and to pick the specialisation once per game.
+enum GameModeId
+{
+    MODE_CLASSIC,
+    MODE_REVERSE,
+    MODE_TIME_ATTACK,
+    MODE_DOUBLE_STEP,
+    MODE_COUNT,
+};
+
+const char *const GAME_MODE_NAMES[MODE_COUNT] = {"Classic", "Reverse", "Time Attack", "Double Step"};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Light sleep on the attract screen.
+//
+// waitForStart() draws the attract animation one frame at a time and
+// calls idleWait() between frames. Until IDLE_AFTER_MS have passed without
+// a button press, a web request or a queued player, idleWait() returns at
+// once and the loop keeps polling as before. After that the cabinet is
+// idle: idleWait() blocks the loop task until the next frame is due or any
+// of the five buttons goes down, whichever comes first.
+//
+// The sleeping itself is left to ESP-IDF's power manager. idleBegin()
+// configures esp_pm for automatic light sleep and holds a CPU_FREQ_MAX
+// lock, so nothing changes while anyone is playing. Entering idle releases
+// the lock: whenever every task is blocked the idle task light-sleeps the
+// chip, waking for the frame timer, a button (GPIO wake-up) and the Wi-Fi
+// driver's DTIM beacons. The station stays in modem sleep, Arduino's
+// default, so it stays associated and a web request waits at most one
+// beacon interval. Leaving idle takes the lock back.
+//
+// Automatic light sleep needs an IDF build with CONFIG_PM_ENABLE and
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE (Arduino as an IDF component). Without
+// them esp_pm_configure() refuses light sleep, the refusal is logged once,
+// and idle only blocks the loop and lowers the clock where the build allows.
+//
+// A button wake returns straight to waitForStart(), which reads the
+// buttons before anything else. idleButtonSeen() (called whenever a press
+// is read) records the time from the button interrupt to the press being
+// seen; over IDLE_WAKE_BUDGET_US prints a warning. The chip's own wake-up
+// time (a few hundred microseconds) comes before the interrupt and isn't
+// visible to esp_timer.
+//
+// Idle current is an estimate, not a measurement: time awake and time
+// waiting while idle, weighted by datasheet currents (see idle_power.cpp).
+// Waits count as light sleep except for the beacons only when esp_pm
+// accepted light sleep; otherwise they are billed at 80 MHz (clock
+// scaling) or full-speed current, and the log line and /metrics say which. The power
+// manager may keep the chip awake for part of a wait, so the estimate is a
+// lower bound. It is printed when the cabinet leaves idle and exported on
+// /metrics next to the raw times, so it can be checked against a meter.
+//
+// The inactivity period is SIMON_IDLE_AFTER_MS (ms, default 60 s); 0
+// disables light sleep.
+
+#ifndef SIMON_IDLE_AFTER_MS
+#define SIMON_IDLE_AFTER_MS 60000
+#endif
+
+const unsigned long IDLE_AFTER_MS = SIMON_IDLE_AFTER_MS;
+const unsigned long ATTRACT_FRAME_MS = 150;
+const uint32_t IDLE_WAKE_BUDGET_US = 5000;
+
+// What idle waits can save in this build (esp_pm_configure()'s answer).
+enum IdlePowerMode : uint8_t
+{
+    IDLE_POWER_LIGHT_SLEEP,   // automatic light sleep plus clock scaling
+    IDLE_POWER_CLOCK_SCALING, // no light sleep: the clock drops to 80 MHz
+    IDLE_POWER_AWAKE,         // no power management at all
+};
+
+struct IdleStats
+{
+    uint64_t sleptUs;       // waiting with light sleep allowed, since boot
+    uint64_t idleAwakeUs;   // awake between waits, since boot
+    uint32_t timerWakes;    // waits ended by the frame timer
+    uint32_t buttonWakes;   // waits ended by a button
+    uint32_t lastWakeLatencyUs; // button interrupt to press seen
+    uint32_t maxWakeLatencyUs;
+    uint32_t modelCurrentUa;    // estimated average over the current or last idle stretch
+    IdlePowerMode powerMode;    // waits are billed at light-sleep, 80 MHz or full-speed current
+};
+
+// Configures button wake-up on the given (active-low) pins and the power
+// manager.
+void idleBegin(const int *buttonPins, int count);
+
+// Something happened: stay awake for another IDLE_AFTER_MS.
+void idleActivity();
+
+// Waits for frameDueMs (a millis() value) or a button when idle, letting
+// the chip light-sleep; otherwise returns at once.
+void idleWait(unsigned long frameDueMs);
+
+// A press was read; counts as activity.
+void idleButtonSeen();
+
+const IdleStats &idleStats();
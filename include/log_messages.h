@@ -0,0 +1,244 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Message table and record format of the deferred logger (deferred_log.h).
+//
+// Every log line the game writes on a hot path is one X(id, level, format)
+// entry below. A call site stores only the id, a timestamp and up to
+// LOG_MAX_ARGS raw 32-bit arguments; the format string never leaves this
+// table (flash on the ESP32) until the drain task, or the host decoder
+// tools/log_decode.cpp, expands the record with logFormat().
+//
+// Arguments are integers (%d %i %u %x %X %c, optionally with l) or floats
+// (%f %e %g, stored as float bits). There is no %s: the record outlives the
+// call, so a pointer argument would be read after its buffer is gone. Flags,
+// width and precision work as in printf. The argument count of every
+// message is derived from its format at compile time and checked at each
+// call site.
+//
+// Add new messages at the end so ids in old binary captures stay valid.
+
+enum LogLevel : uint8_t
+{
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+};
+
+#define SIMON_LOG_MESSAGES(X)                                                                                  \
+    X(LOG_LOGGER_UP, LOG_LEVEL_INFO, "📝 Deferred log on: %u slots, level %u")                                \
+    X(LOG_DROPPED, LOG_LEVEL_WARN, "⚠️ Log ring full: %u messages dropped")                                   \
+    X(LOG_ROUND_START, LOG_LEVEL_DEBUG, "🔁 Round with %u steps, %u ms per step")                              \
+    X(LOG_PRESS, LOG_LEVEL_DEBUG, "👆 Button %d after %lu ms, correct %d")                                     \
+    X(LOG_ROUND_CLEARED, LOG_LEVEL_INFO, "Correct! Score: %d")                                                 \
+    X(LOG_TIMES_UP, LOG_LEVEL_INFO, "⏰ Time's up!")                                                           \
+    X(LOG_ABANDONED, LOG_LEVEL_INFO, "💤 Nobody is pressing, ending the game")                                 \
+    X(LOG_MARATHON_COMPLETE, LOG_LEVEL_INFO, "🏁 Marathon complete!")                                          \
+    X(LOG_GAME_OVER, LOG_LEVEL_INFO, "❌ Game Over!")                                                          \
+    X(LOG_FINAL_SCORE, LOG_LEVEL_INFO, "🏆 Final Score: %d")                                                   \
+    X(LOG_UPLOAD_NO_USER, LOG_LEVEL_WARN, "❌ No user logged in. Skipping score upload.")                      \
+    X(LOG_UPLOAD_OFFLINE, LOG_LEVEL_WARN, "❌ Wi-Fi offline. Skipping score upload.")                          \
+    X(LOG_UPLOAD_JSON_FALLBACK, LOG_LEVEL_WARN, "⚠️ Backend rejected MessagePack, switching to JSON")          \
+    X(LOG_UPLOAD_OK, LOG_LEVEL_INFO, "✅ Score uploaded successfully! (%lu ms)")                               \
+    X(LOG_UPLOAD_FAILED, LOG_LEVEL_ERROR, "❌ Failed to upload score. (HTTP %d after %lu ms, %u failed so far)") \
+    X(LOG_WIFI_LOST, LOG_LEVEL_WARN, "❌ Wi-Fi link lost, reconnecting in background")                         \
+    X(LOG_WIFI_CACHE_FAILED, LOG_LEVEL_WARN, "⚠️ Cached Wi-Fi link failed, doing a full connect")              \
+    X(LOG_WIFI_RETRY, LOG_LEVEL_WARN, "⏳ Wi-Fi connect failed, retrying in %lu ms")                           \
+    X(LOG_WIFI_UP_CACHED, LOG_LEVEL_INFO, "✅ Wi-Fi up in %lu ms (cached link)")                               \
+    X(LOG_WIFI_UP_FULL, LOG_LEVEL_INFO, "✅ Wi-Fi up in %lu ms (full connect)")                                \
+    X(LOG_WIFI_RECONNECTED, LOG_LEVEL_INFO, "↩️ Wi-Fi back %lu ms after drop #%u")                            \
+    X(LOG_IDLE_ENTER, LOG_LEVEL_INFO, "💤 Idle: waiting between attract frames")                               \
+    X(LOG_IDLE_LEAVE, LOG_LEVEL_INFO, "☀️ Idle for %lu s, %u%% in light sleep, ~%lu uA estimated (%lu uA awake)") \
+    X(LOG_IDLE_WAKE_SLOW, LOG_LEVEL_WARN, "⚠️ Button wake took %lu us to the first read")                    \
+    X(LOG_SETTINGS_LOADED, LOG_LEVEL_INFO, "⚙️ Settings restored %u: folder %u, volume %u, login %u")          \
+    X(LOG_SETTINGS_SAVED, LOG_LEVEL_INFO, "💾 Settings saved in %lu us")                                       \
+    X(LOG_BOOT_PLAYABLE, LOG_LEVEL_INFO, "🚀 Playable %lu ms after boot (saved settings %u)")                  \
+    X(LOG_UPLOAD_TOO_LARGE, LOG_LEVEL_ERROR, "❌ Score body does not fit in %u bytes, not uploaded")           \
+    X(LOG_IDLE_NO_LIGHT_SLEEP, LOG_LEVEL_WARN, "⚠️ No auto light sleep in this build (esp_pm %d, clock scaling only: %d)") \
+    X(LOG_IDLE_LEAVE_NO_SLEEP, LOG_LEVEL_INFO, "☀️ Idle for %lu s, %u%% waiting awake (no light sleep), ~%lu uA estimated (%lu uA awake)") \
+    X(LOG_METRICS_ROUTES_FULL, LOG_LEVEL_WARN, "⚠️ /metrics has no label left for a route past %d, counted as other")
+
+const int LOG_MAX_ARGS = 4;
+
+// Number of conversions in a format ("%%" is not one).
+constexpr uint8_t logArgCount(const char *format)
+{
+    uint8_t count = 0;
+    for (const char *p = format; *p; p++)
+    {
+        if (*p == '%')
+        {
+            if (p[1] == '%')
+            {
+                p++;
+            }
+            else
+            {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+enum LogId : uint16_t
+{
+#define SIMON_LOG_ID(id, level, format) id,
+    SIMON_LOG_MESSAGES(SIMON_LOG_ID)
+#undef SIMON_LOG_ID
+    LOG_ID_COUNT,
+};
+
+struct LogMessage
+{
+    LogLevel level;
+    uint8_t argc;
+    const char *format;
+};
+
+constexpr LogMessage LOG_MESSAGES[LOG_ID_COUNT] = {
+#define SIMON_LOG_ENTRY(id, level, format) {level, logArgCount(format), format},
+    SIMON_LOG_MESSAGES(SIMON_LOG_ENTRY)
+#undef SIMON_LOG_ENTRY
+};
+
+constexpr bool logArgCountsFit()
+{
+    for (const LogMessage &message : LOG_MESSAGES)
+    {
+        if (message.argc > LOG_MAX_ARGS)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(logArgCountsFit(), "a log message has more than LOG_MAX_ARGS conversions");
+
+struct LogRecord
+{
+    uint32_t atUs; // low 32 bits of the microsecond clock when logged
+    uint16_t id;
+    uint8_t argc;
+    uint8_t reserved;
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+inline uint32_t logWord(int value) { return (uint32_t)value; }
+inline uint32_t logWord(unsigned value) { return value; }
+inline uint32_t logWord(long value) { return (uint32_t)value; }
+inline uint32_t logWord(unsigned long value) { return (uint32_t)value; }
+inline uint32_t logWord(bool value) { return value; }
+inline uint32_t logWord(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+inline uint32_t logWord(double value) { return logWord((float)value); }
+
+// Expands a record into out (always terminated); returns the text length,
+// capped at size - 1.
+inline size_t logFormat(char *out, size_t size, const LogRecord &record)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (record.id >= LOG_ID_COUNT)
+    {
+        snprintf(out, size, "<unknown log id %u>", (unsigned)record.id);
+        return strlen(out);
+    }
+    size_t n = 0;
+    uint8_t arg = 0;
+    for (const char *p = LOG_MESSAGES[record.id].format; *p && n < size - 1;)
+    {
+        if (*p != '%' || p[1] == '%')
+        {
+            out[n++] = *p;
+            p += *p == '%' ? 2 : 1;
+            continue;
+        }
+
+        // Copy one conversion spec ("%-6lu") so snprintf sees it verbatim.
+        char spec[16];
+        size_t length = 0;
+        bool isLong = false;
+        spec[length++] = *p++;
+        while (*p && strchr("-+ #0123456789.lh", *p) && length < sizeof(spec) - 3)
+        {
+            isLong |= *p == 'l';
+            spec[length++] = *p++;
+        }
+        char conversion = *p ? *p++ : 'd';
+        spec[length++] = conversion;
+        spec[length] = '\0';
+
+        uint32_t word = arg < record.argc ? record.args[arg] : 0;
+        arg++;
+        int written;
+        if (strchr("feEgG", conversion))
+        {
+            float value;
+            memcpy(&value, &word, sizeof(value));
+            written = snprintf(out + n, size - n, spec, (double)value);
+        }
+        else if (conversion == 'd' || conversion == 'i')
+        {
+            written = isLong ? snprintf(out + n, size - n, spec, (long)(int32_t)word)
+                             : snprintf(out + n, size - n, spec, (int)(int32_t)word);
+        }
+        else
+        {
+            written = isLong ? snprintf(out + n, size - n, spec, (unsigned long)word)
+                             : snprintf(out + n, size - n, spec, (unsigned)word);
+        }
+        if (written < 0)
+        {
+            break;
+        }
+        n += (size_t)written < size - n ? (size_t)written : size - 1 - n;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Binary framing for SIMON_LOG_BINARY captures: sync, the record in
+// little-endian order (both the ESP32 and the usual hosts are), checksum.
+const uint8_t LOG_FRAME_SYNC[2] = {0xa5, 0x5a};
+const size_t LOG_FRAME_SIZE = sizeof(LOG_FRAME_SYNC) + sizeof(LogRecord) + 1;
+
+inline uint8_t logChecksum(const uint8_t *data, size_t length)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        sum = (uint8_t)((sum << 1 | sum >> 7) ^ data[i]);
+    }
+    return sum;
+}
+
+inline void logEncodeFrame(uint8_t *frame, const LogRecord &record)
+{
+    memcpy(frame, LOG_FRAME_SYNC, sizeof(LOG_FRAME_SYNC));
+    memcpy(frame + sizeof(LOG_FRAME_SYNC), &record, sizeof(record));
+    frame[LOG_FRAME_SIZE - 1] = logChecksum(frame + sizeof(LOG_FRAME_SYNC), sizeof(record));
+}
+
+// False unless frame holds a well-formed record of a known message.
+inline bool logDecodeFrame(const uint8_t *frame, LogRecord &record)
+{
+    if (memcmp(frame, LOG_FRAME_SYNC, sizeof(LOG_FRAME_SYNC)) != 0 ||
+        logChecksum(frame + sizeof(LOG_FRAME_SYNC), sizeof(record)) != frame[LOG_FRAME_SIZE - 1])
+    {
+        return false;
+    }
+    memcpy(&record, frame + sizeof(LOG_FRAME_SYNC), sizeof(record));
+    return record.id < LOG_ID_COUNT && record.argc == LOG_MESSAGES[record.id].argc;
+}
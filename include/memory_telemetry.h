@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Heap and stack telemetry in a fixed ring of recent samples.
+//
+// Each sample records free heap, the minimum free heap since boot, the
+// largest allocatable block and the stack high-water mark (least free
+// stack ever seen) of every watched FreeRTOS task. Samples are taken at
+// round start, game over and the end of each JSON request, and every
+// MEMORY_SAMPLE_INTERVAL_MS from memoryPoll().
+//
+// A sample below any warning threshold prints a warning on Serial the
+// first time it happens (and again after recovering), well before the
+// device would reset. GET /memory returns the whole ring as JSON.
+
+const int MEMORY_RING_SIZE = 32;
+const int MEMORY_MAX_TASKS = 8;
+const unsigned long MEMORY_SAMPLE_INTERVAL_MS = 10000;
+
+const uint32_t MEMORY_WARN_FREE_HEAP = 24 * 1024;
+const uint32_t MEMORY_WARN_LARGEST_BLOCK = 8 * 1024; // HTTPClient needs a few KB in one piece
+const uint32_t MEMORY_WARN_STACK_FREE = 512;
+
+enum MemoryPoint : uint8_t
+{
+    MEMORY_PERIODIC,
+    MEMORY_ROUND_START,
+    MEMORY_GAME_OVER,
+    MEMORY_REQUEST_END,
+    MEMORY_BOOT,
+};
+
+struct MemorySample
+{
+    unsigned long atMs;
+    MemoryPoint point;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    uint32_t largestBlock;
+    uint16_t stackFree[MEMORY_MAX_TASKS]; // bytes, in memoryTaskName() order
+};
+
+// Watches the calling task (loopTask), both idle tasks and the Wi-Fi/lwIP
+// tasks, and registers GET /memory.
+void memoryBegin(WebServer &server);
+
+// Adds a task created later (e.g. a logger or boot task). Ignored when full.
+void memoryWatchTask(const char *name, TaskHandle_t task);
+
+const MemorySample &memorySample(MemoryPoint point);
+void memoryPoll();
+
+int memoryTaskCount();
+const char *memoryTaskName(int index);
+const MemorySample *memoryLatest();
+
+// One-line summary of the latest sample, e.g. after every game.
+void memoryPrint(Print &out);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#include "metrics_registry.h"
+
+// Prometheus endpoint: GET /metrics on the device's web server.
+//
+// Game code records through the hooks below; each is a counter increment.
+// HTTP requests are timed by a probe handler that metricsBegin() installs
+// ahead of every route: WebServer asks it first whether it handles the
+// request, it notes the route and the time and declines, and
+// metricsRequestDone() (called right after server.handleClient()) records
+// the latency. Every route is registered through metricsOn() rather than
+// server.on(), which gives it its own label, so a new endpoint cannot be
+// left out of /metrics.
+//
+// A scrape streams the registry as chunked text straight from the
+// counters (see metrics_registry.h); its own duration and size are
+// exported in the following scrape and show up in /profile as
+// metricsScrape when the profiler is built in.
+
+// Must run before any other route is registered so the probe is the first handler.
+void metricsBegin(WebServer &server);
+// True when a request was handled since the last call.
+bool metricsRequestDone();
+
+// server.on(), plus a /metrics label for uri. Call after metricsBegin().
+void metricsOn(WebServer &server, const char *uri, HTTPMethod method, WebServer::THandlerFunction handler);
+void metricsOn(WebServer &server, const char *uri, HTTPMethod method, WebServer::THandlerFunction handler,
+               WebServer::THandlerFunction upload);
+
+void metricsButtonPress(int button);
+void metricsDfplayerCommand();
+void metricsGamePlayed(uint32_t rounds, int score);
+// Returns how many uploads ended with this result so far. latencyUs is
+// recorded for uploads that reached the network; pass 0 for the others.
+uint32_t metricsScoreUpload(MetricsUpload result, uint32_t latencyUs = 0);
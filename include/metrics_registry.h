@@ -0,0 +1,431 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fixed_string.h"
+
+// Counters behind GET /metrics and their Prometheus text rendering.
+//
+// Every metric is a plain integer in one static MetricsRegistry, so
+// recording is an increment and a scrape reads the live values without
+// locking or copying. renderMetrics() writes the text exposition format
+// (version 0.0.4) through PrometheusWriter, which fills a fixed buffer and
+// hands each full buffer to a sink: the HTTP chunk writer on the device, a
+// byte counter in the host benchmark. Nothing allocates, so a scrape costs
+// the same after a month of uptime as right after boot.
+//
+// Histograms keep one counter per bucket and are made cumulative while
+// rendering. Latencies are stored in microseconds and rendered in seconds.
+//
+// No Arduino dependencies: tools/bench_hot_paths.cpp renders this exact
+// code. The device glue (hooks, gauges, the route probe) is in metrics.h.
+
+const int METRICS_BUTTONS = 5;
+
+// Routes get their own label as they are registered (metricsOn() in
+// metrics.h); anything else is counted as "other" so a scanner probing
+// random paths cannot grow the label set. The firmware registers 16.
+const int METRICS_MAX_ROUTES = 24;
+const int METRICS_ROUTE_OTHER = METRICS_MAX_ROUTES; // requestLatency slot past the registered ones
+
+const uint32_t METRICS_ROUND_BOUNDS[] = {1, 2, 4, 8, 16, 32, 64, 128};
+const uint32_t METRICS_SCORE_BOUNDS[] = {0, 10, 25, 50, 100, 250, 500, 1000};
+const uint32_t METRICS_LATENCY_BOUNDS_US[] = {5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000};
+// An upload may take the 2 s connect plus 3 s response timeout, twice with the JSON retry
+const uint32_t METRICS_UPLOAD_BOUNDS_US[] = {25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+enum MetricsUpload : uint8_t
+{
+    METRICS_UPLOAD_SUCCEEDED,
+    METRICS_UPLOAD_FAILED,
+    METRICS_UPLOAD_SKIPPED, // Wi-Fi down
+    METRICS_UPLOAD_COUNT,
+};
+
+template <size_t Bounds>
+struct MetricsHistogram
+{
+    uint32_t buckets[Bounds + 1]; // the last one is +Inf
+    uint32_t count;
+    uint64_t sum;
+
+    void observe(const uint32_t (&bounds)[Bounds], uint32_t value)
+    {
+        size_t i = 0;
+        while (i < Bounds && value > bounds[i])
+        {
+            i++;
+        }
+        buckets[i]++;
+        count++;
+        sum += value;
+    }
+};
+
+struct MetricsRegistry
+{
+    MetricsHistogram<8> rounds; // count = games played
+    MetricsHistogram<8> scores;
+    uint32_t buttonPresses[METRICS_BUTTONS];
+    uint32_t dfplayerCommands;
+    uint32_t scoreUploads[METRICS_UPLOAD_COUNT];
+    MetricsHistogram<9> uploadLatency; // attempts that reached the network
+    const char *routes[METRICS_MAX_ROUTES]; // registered URIs, in registration order
+    int routeCount;
+    MetricsHistogram<9> requestLatency[METRICS_MAX_ROUTES + 1]; // per route, then "other"
+};
+
+// Values read at scrape time rather than counted.
+struct MetricsGauges
+{
+    uint32_t wifiReconnects;
+    uint32_t wifiFailedAttempts;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    uint64_t uptimeUs;
+    uint32_t lastScrapeUs; // cost of the previous scrape, measured by the device
+    uint32_t lastScrapeBytes;
+    uint32_t logDropped;
+    uint64_t idleSleptUs;
+    uint64_t idleAwakeUs;
+    uint32_t idleTimerWakes;
+    uint32_t idleButtonWakes;
+    uint32_t idleWakeLatencyMaxUs;
+    uint32_t idleModelCurrentUa;
+    uint8_t idlePowerMode; // IdlePowerMode
+};
+
+inline int metricsRouteIndex(const MetricsRegistry &m, const char *uri)
+{
+    for (int i = 0; i < m.routeCount; i++)
+    {
+        if (strcmp(uri, m.routes[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return METRICS_ROUTE_OTHER;
+}
+
+// Gives uri its own label; a URI registered for a second method keeps its
+// first one. uri must outlive the registry (a string literal). False when
+// all METRICS_MAX_ROUTES labels are taken.
+inline bool metricsAddRoute(MetricsRegistry &m, const char *uri)
+{
+    if (metricsRouteIndex(m, uri) != METRICS_ROUTE_OTHER)
+    {
+        return true;
+    }
+    if (m.routeCount == METRICS_MAX_ROUTES)
+    {
+        return false;
+    }
+    m.routes[m.routeCount++] = uri;
+    return true;
+}
+
+// Writes exposition lines into a Capacity-byte buffer; sink.write(data,
+// length) receives the buffer whenever the next line might not fit, and
+// once more from finish().
+template <class Sink, size_t Capacity = 512>
+class PrometheusWriter
+{
+public:
+    static const size_t LINE_MAX = 160; // longest single line written, with room to spare
+
+    explicit PrometheusWriter(Sink &sink) : sink_(sink) {}
+
+    void family(const char *name, const char *type, const char *help)
+    {
+        reserveLine();
+        put("# HELP ");
+        put(name);
+        put(' ');
+        put(help);
+        put('\n');
+        reserveLine();
+        put("# TYPE ");
+        put(name);
+        put(' ');
+        put(type);
+        put('\n');
+    }
+
+    // name{label="value"} v; label may be nullptr for an unlabelled sample.
+    void sample(const char *name, const char *label, const char *value, uint64_t v)
+    {
+        openSample(name, "", label, value, nullptr);
+        putUnsigned(v);
+        put('\n');
+    }
+
+    void sampleSeconds(const char *name, const char *label, const char *value, uint64_t micros)
+    {
+        openSample(name, "", label, value, nullptr);
+        putSeconds(micros);
+        put('\n');
+    }
+
+    template <size_t Bounds>
+    void histogram(const char *name, const char *label, const char *value, const MetricsHistogram<Bounds> &h,
+                   const uint32_t (&bounds)[Bounds], bool micros)
+    {
+        char le[INT_TEXT_MAX + 8];
+        uint32_t cumulative = 0;
+        for (size_t i = 0; i <= Bounds; i++)
+        {
+            cumulative += h.buckets[i];
+            if (i == Bounds)
+            {
+                strcpy(le, "+Inf");
+            }
+            else if (micros)
+            {
+                le[formatSeconds(le, bounds[i])] = '\0';
+            }
+            else
+            {
+                le[formatUnsigned(le, bounds[i])] = '\0';
+            }
+            openSample(name, "_bucket", label, value, le);
+            putUnsigned(cumulative);
+            put('\n');
+        }
+        openSample(name, "_sum", label, value, nullptr);
+        if (micros)
+        {
+            putSeconds(h.sum);
+        }
+        else
+        {
+            putUnsigned(h.sum);
+        }
+        put('\n');
+        openSample(name, "_count", label, value, nullptr);
+        putUnsigned(h.count);
+        put('\n');
+    }
+
+    void finish()
+    {
+        flush();
+    }
+
+    size_t bytes() const { return written_ + used_; }
+
+private:
+    void openSample(const char *name, const char *suffix, const char *label, const char *value, const char *le)
+    {
+        reserveLine();
+        put(name);
+        put(suffix);
+        if (label || le)
+        {
+            put('{');
+            if (label)
+            {
+                put(label);
+                put("=\"");
+                put(value);
+                put('"');
+            }
+            if (le)
+            {
+                put(label ? ",le=\"" : "le=\"");
+                put(le);
+                put('"');
+            }
+            put('}');
+        }
+        put(' ');
+    }
+
+    void reserveLine()
+    {
+        if (Capacity - used_ < LINE_MAX)
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if (used_)
+        {
+            sink_.write(buffer_, used_);
+            written_ += used_;
+            used_ = 0;
+        }
+    }
+
+    void put(char c)
+    {
+        if (used_ < Capacity)
+        {
+            buffer_[used_++] = c;
+        }
+    }
+
+    void put(const char *text)
+    {
+        size_t length = strlen(text);
+        if (length > Capacity - used_)
+        {
+            length = Capacity - used_;
+        }
+        memcpy(buffer_ + used_, text, length);
+        used_ += length;
+    }
+
+    void putUnsigned(uint64_t value)
+    {
+        char digits[INT_TEXT_MAX];
+        size_t n = 0;
+        do
+        {
+            digits[n++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (n > 0 && used_ < Capacity)
+        {
+            buffer_[used_++] = digits[--n];
+        }
+    }
+
+    void putSeconds(uint64_t micros)
+    {
+        char text[INT_TEXT_MAX + 8];
+        size_t n;
+        if (micros <= 0xffffffffu)
+        {
+            n = formatSeconds(text, (uint32_t)micros);
+        }
+        else
+        {
+            putUnsigned(micros / 1000000);
+            n = formatSeconds(text, (uint32_t)(micros % 1000000));
+            memmove(text, text + 1, --n); // drop the leading "0"
+        }
+        text[n] = '\0';
+        put(text);
+    }
+
+    // "1.25", "0.005": integer seconds, then the fraction without trailing zeros.
+    static size_t formatSeconds(char *out, uint32_t micros)
+    {
+        size_t n = formatUnsigned(out, micros / 1000000ul);
+        uint32_t fraction = micros % 1000000;
+        if (fraction)
+        {
+            out[n++] = '.';
+            for (uint32_t scale = 100000; fraction; scale /= 10)
+            {
+                out[n++] = (char)('0' + fraction / scale);
+                fraction %= scale;
+            }
+        }
+        return n;
+    }
+
+    Sink &sink_;
+    char buffer_[Capacity];
+    size_t used_ = 0;
+    size_t written_ = 0;
+};
+
+template <class Sink, size_t Capacity>
+void renderMetrics(PrometheusWriter<Sink, Capacity> &out, const MetricsRegistry &m, const MetricsGauges &g)
+{
+    out.family("simon_games_played_total", "counter", "Games finished since boot.");
+    out.sample("simon_games_played_total", nullptr, nullptr, m.rounds.count);
+
+    out.family("simon_game_rounds", "histogram", "Rounds reached per game.");
+    out.histogram("simon_game_rounds", nullptr, nullptr, m.rounds, METRICS_ROUND_BOUNDS, false);
+
+    out.family("simon_game_score", "histogram", "Final score per game.");
+    out.histogram("simon_game_score", nullptr, nullptr, m.scores, METRICS_SCORE_BOUNDS, false);
+
+    out.family("simon_button_presses_total", "counter", "Debounced button presses per channel.");
+    for (int i = 0; i < METRICS_BUTTONS; i++)
+    {
+        const char channel[2] = {(char)('0' + i), '\0'};
+        out.sample("simon_button_presses_total", "button", channel, m.buttonPresses[i]);
+    }
+
+    out.family("simon_dfplayer_commands_total", "counter", "Command frames sent to the DFPlayer.");
+    out.sample("simon_dfplayer_commands_total", nullptr, nullptr, m.dfplayerCommands);
+
+    static const char *const UPLOAD_RESULTS[METRICS_UPLOAD_COUNT] = {"succeeded", "failed", "skipped"};
+    out.family("simon_score_uploads_total", "counter", "Score uploads to the backend by result.");
+    for (int i = 0; i < METRICS_UPLOAD_COUNT; i++)
+    {
+        out.sample("simon_score_uploads_total", "result", UPLOAD_RESULTS[i], m.scoreUploads[i]);
+    }
+    out.family("simon_score_upload_duration_seconds", "histogram",
+               "Score upload time from connect to response, as the device sees it.");
+    out.histogram("simon_score_upload_duration_seconds", nullptr, nullptr, m.uploadLatency, METRICS_UPLOAD_BOUNDS_US,
+                  true);
+
+    // Registered routes, then "other" in the slot after the last possible one
+    out.family("simon_http_requests_total", "counter", "HTTP requests handled, per route.");
+    for (int i = 0; i <= m.routeCount; i++)
+    {
+        int slot = i < m.routeCount ? i : METRICS_ROUTE_OTHER;
+        const char *route = i < m.routeCount ? m.routes[i] : "other";
+        out.sample("simon_http_requests_total", "route", route, m.requestLatency[slot].count);
+    }
+
+    out.family("simon_http_request_duration_seconds", "histogram",
+               "Time from handler lookup to the end of the response, per route.");
+    for (int i = 0; i <= m.routeCount; i++)
+    {
+        int slot = i < m.routeCount ? i : METRICS_ROUTE_OTHER;
+        const char *route = i < m.routeCount ? m.routes[i] : "other";
+        out.histogram("simon_http_request_duration_seconds", "route", route, m.requestLatency[slot],
+                      METRICS_LATENCY_BOUNDS_US, true);
+    }
+
+    out.family("simon_wifi_reconnects_total", "counter", "Wi-Fi links re-established after a drop.");
+    out.sample("simon_wifi_reconnects_total", nullptr, nullptr, g.wifiReconnects);
+    out.family("simon_wifi_failed_attempts_total", "counter", "Wi-Fi connect attempts that timed out.");
+    out.sample("simon_wifi_failed_attempts_total", nullptr, nullptr, g.wifiFailedAttempts);
+
+    out.family("simon_heap_free_bytes", "gauge", "Free 8-bit heap.");
+    out.sample("simon_heap_free_bytes", nullptr, nullptr, g.freeHeap);
+    out.family("simon_heap_min_free_bytes", "gauge", "Lowest free 8-bit heap since boot.");
+    out.sample("simon_heap_min_free_bytes", nullptr, nullptr, g.minFreeHeap);
+
+    out.family("simon_log_dropped_total", "counter", "Deferred log messages dropped because the ring was full.");
+    out.sample("simon_log_dropped_total", nullptr, nullptr, g.logDropped);
+
+    out.family("simon_idle_sleep_seconds_total", "counter", "Time the idle attract screen waited with light sleep allowed.");
+    out.sampleSeconds("simon_idle_sleep_seconds_total", nullptr, nullptr, g.idleSleptUs);
+    out.family("simon_idle_awake_seconds_total", "counter", "Time awake between idle waits.");
+    out.sampleSeconds("simon_idle_awake_seconds_total", nullptr, nullptr, g.idleAwakeUs);
+    out.family("simon_idle_wakes_total", "counter", "Idle waits ended, by cause.");
+    out.sample("simon_idle_wakes_total", "cause", "timer", g.idleTimerWakes);
+    out.sample("simon_idle_wakes_total", "cause", "button", g.idleButtonWakes);
+    out.family("simon_idle_wake_latency_max_seconds", "gauge", "Longest time from a button interrupt to the press being read.");
+    out.sampleSeconds("simon_idle_wake_latency_max_seconds", nullptr, nullptr, g.idleWakeLatencyMaxUs);
+    // Microamps scale to amperes exactly like microseconds to seconds
+    out.family("simon_idle_current_estimate_amperes", "gauge",
+               "Estimated average current of the last idle stretch, from datasheet figures, not measured.");
+    out.sampleSeconds("simon_idle_current_estimate_amperes", nullptr, nullptr, g.idleModelCurrentUa);
+    static const char *const IDLE_POWER_MODES[] = {"light_sleep", "clock_scaling", "awake"};
+    out.family("simon_idle_power_mode", "gauge", "How idle waits save power in this build; the estimate bills them accordingly.");
+    for (int i = 0; i < 3; i++)
+    {
+        out.sample("simon_idle_power_mode", "mode", IDLE_POWER_MODES[i], g.idlePowerMode == i ? 1 : 0);
+    }
+
+    out.family("simon_uptime_seconds", "gauge", "Time since boot.");
+    out.sampleSeconds("simon_uptime_seconds", nullptr, nullptr, g.uptimeUs);
+
+    out.family("simon_metrics_scrape_duration_seconds", "gauge", "Time the previous /metrics scrape took to render and send.");
+    out.sampleSeconds("simon_metrics_scrape_duration_seconds", nullptr, nullptr, g.lastScrapeUs);
+    out.family("simon_metrics_scrape_bytes", "gauge", "Size of the previous /metrics response.");
+    out.sample("simon_metrics_scrape_bytes", nullptr, nullptr, g.lastScrapeBytes);
+    out.finish();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded lock-free ring: any number of producers, one consumer.
+//
+// Producers reserve a slot by compare-and-swap on head and publish it by
+// storing the slot's sequence number after the payload, so a task that is
+// preempted (or running on the other core) between reserving and writing
+// never blocks anyone: the consumer just stops at the unpublished slot and
+// picks it up on its next pass. A full ring rejects the push and counts it
+// in dropped(); producers never wait for the consumer.
+//
+// Used for the profiler's per-core rings and the deferred log. No Arduino
+// dependencies, so the host benchmark measures this exact code.
+
+template <class T, size_t Slots>
+class MpscRing
+{
+public:
+    static_assert(Slots > 0 && (Slots & (Slots - 1)) == 0, "slot count must be a power of two");
+
+    bool push(const T &item)
+    {
+        uint32_t slot = head_.load(std::memory_order_relaxed);
+        do
+        {
+            if (slot - tail_.load(std::memory_order_acquire) >= (uint32_t)Slots)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!head_.compare_exchange_weak(slot, slot + 1, std::memory_order_acq_rel));
+
+        Cell &cell = cells_[slot % Slots];
+        cell.item = item;
+        cell.sequence.store(slot + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. False when empty or the oldest slot is not published yet.
+    bool pop(T &item)
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        Cell &cell = cells_[tail % Slots];
+        if (cell.sequence.load(std::memory_order_acquire) != tail + 1)
+        {
+            return false;
+        }
+        item = cell.item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const { return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed); }
+    static constexpr size_t capacity() { return Slots; }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint32_t> sequence{0}; // slot number + 1 once written
+        T item;
+    };
+
+    std::atomic<uint32_t> head_{0}; // next slot to reserve
+    std::atomic<uint32_t> tail_{0}; // next slot to pop
+    std::atomic<uint32_t> dropped_{0};
+    Cell cells_[Slots];
+};
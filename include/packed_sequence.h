@@ -0,0 +1,146 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Storage for the Simon sequence.
+//
+// PackedSequence keeps each step (0..4) in 3 bits, ten steps per 32-bit word,
+// in a fixed array sized at compile time: no heap, no reallocation as the game
+// grows. 10,000 steps take 4,000 bytes instead of the 40,000+ a
+// std::vector<int> needs (before its growth slack).
+//
+// SeededSequence stores no steps at all, only a seed and a length. Step i is
+// derived from (seed, i) with an integer hash, so any step can be regenerated
+// in O(1) and the whole sequence costs 8 bytes regardless of length.
+
+template <size_t Capacity>
+class PackedSequence
+{
+public:
+    static const int BITS_PER_STEP = 3;
+    static const int STEPS_PER_WORD = 10;
+    static const uint32_t STEP_MASK = (1u << BITS_PER_STEP) - 1;
+
+    // Walks the words sequentially so iteration costs a shift per step
+    // instead of a divide.
+    class Iterator
+    {
+    public:
+        Iterator(const uint32_t *word, size_t index) : word_(word), index_(index), slot_(0), bits_(word ? *word : 0) {}
+
+        uint8_t operator*() const { return bits_ & STEP_MASK; }
+        bool operator!=(const Iterator &other) const { return index_ != other.index_; }
+        Iterator &operator++()
+        {
+            index_++;
+            if (++slot_ == STEPS_PER_WORD)
+            {
+                slot_ = 0;
+                bits_ = *++word_;
+            }
+            else
+            {
+                bits_ >>= BITS_PER_STEP;
+            }
+            return *this;
+        }
+
+    private:
+        const uint32_t *word_;
+        size_t index_;
+        int slot_;
+        uint32_t bits_;
+    };
+
+    size_t size() const { return length_; }
+    static constexpr size_t capacity() { return Capacity; }
+    bool full() const { return length_ == Capacity; }
+    void clear() { length_ = 0; }
+
+    // Returns false (and stores nothing) once the capacity is reached.
+    bool push_back(uint8_t step)
+    {
+        if (length_ == Capacity)
+        {
+            return false;
+        }
+        uint32_t &word = words_[length_ / STEPS_PER_WORD];
+        int shift = (length_ % STEPS_PER_WORD) * BITS_PER_STEP;
+        word = (word & ~(STEP_MASK << shift)) | ((uint32_t)step << shift);
+        length_++;
+        return true;
+    }
+
+    uint8_t operator[](size_t index) const
+    {
+        return (words_[index / STEPS_PER_WORD] >> ((index % STEPS_PER_WORD) * BITS_PER_STEP)) & STEP_MASK;
+    }
+
+    Iterator begin() const { return Iterator(words_, 0); }
+    Iterator end() const { return Iterator(nullptr, length_); }
+
+private:
+    // One spare word so the iterator may preload past the last full word.
+    uint32_t words_[Capacity / STEPS_PER_WORD + 2] = {};
+    size_t length_ = 0;
+};
+
+class SeededSequence
+{
+public:
+    static const uint8_t BUTTONS = 5;
+
+    class Iterator
+    {
+    public:
+        Iterator(const SeededSequence *sequence, size_t index) : sequence_(sequence), index_(index) {}
+
+        uint8_t operator*() const { return (*sequence_)[index_]; }
+        bool operator!=(const Iterator &other) const { return index_ != other.index_; }
+        Iterator &operator++()
+        {
+            index_++;
+            return *this;
+        }
+
+    private:
+        const SeededSequence *sequence_;
+        size_t index_;
+    };
+
+    void reset(uint32_t seed)
+    {
+        seed_ = seed;
+        length_ = 0;
+    }
+
+    size_t size() const { return length_; }
+    void grow() { length_++; }
+
+    uint8_t operator[](size_t index) const
+    {
+        // Multiply-shift maps the 32-bit hash onto 0..4 (bias below 1e-9).
+        return (uint8_t)(((uint64_t)hash(seed_ + (uint32_t)index * 0x9E3779B9u) * BUTTONS) >> 32);
+    }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, length_); }
+
+    uint32_t seed() const { return seed_; }
+
+private:
+    // lowbias32 integer finalizer (Chris Wellons' hash-prospector).
+    static uint32_t hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    uint32_t seed_ = 0;
+    size_t length_ = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+// PCG32 (XSH-RR variant, O'Neill 2014): 8 bytes of state, one 64-bit
+// multiply per output, fully reproducible from its seed. Replaces Arduino
+// random(), which is never seeded and cannot be replayed.
+//
+// The same seed gives the same sequence on the ESP32 and on a PC, so a game
+// can be regenerated on host from the seed sent with its score.
+
+class Pcg32
+{
+public:
+    explicit Pcg32(uint32_t seed = 0) { reseed(seed); }
+
+    void reseed(uint32_t seed)
+    {
+        state_ = 0;
+        next();
+        state_ += seed;
+        next();
+    }
+
+    uint32_t next()
+    {
+        uint64_t old = state_;
+        state_ = old * MULTIPLIER + INCREMENT;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // Unbiased value in [0, range) using Lemire's multiply-and-reject method;
+    // the rejection branch is taken with probability (2^32 mod range) / 2^32.
+    uint32_t bounded(uint32_t range)
+    {
+        uint64_t m = (uint64_t)next() * range;
+        uint32_t low = (uint32_t)m;
+        if (low < range)
+        {
+            uint32_t threshold = (0u - range) % range;
+            while (low < threshold)
+            {
+                m = (uint64_t)next() * range;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+private:
+    static const uint64_t MULTIPLIER = 6364136223846793005ULL;
+    static const uint64_t INCREMENT = 1442695040888963407ULL; // fixed stream
+
+    uint64_t state_;
+};
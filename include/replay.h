@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Compact binary replay of every game, kept on LittleFS in a rolling window
+// of the last REPLAY_SLOTS games.
+//
+// File layout (little endian):
+//     "SSR1"            magic + format version
+//     u32 game number   increases across reboots, picks the newest slot
+//     u32 seed          PCG32 seed of the game
+//     u8  sound folder
+//     u8  game mode     GameModeId, e.g. reverse order changes what a press must match
+//     records...        one varint each: (deltaMs << 4) | code
+//
+// deltaMs is the time since the previous record. Codes:
+//     0..4   player pressed button 0..4
+//     5..9   Simon added step 0..4 to the sequence
+//     15     game over, followed by a varint with the final score
+//
+// Records are collected in RAM and only written to flash from
+// replayFlush(), which the game calls while Simon is playing back (input
+// is not being read then), so a flash write never delays a press.
+//
+// tools/replay_reader.cpp prints and checks a downloaded replay on a PC.
+
+const int REPLAY_SLOTS = 8;
+const int REPLAY_BUFFER_SIZE = 512;
+
+void replayBegin(WebServer &server); // routes only
+void replayMount();                   // LittleFS, formatted on first use; a boot step of its own
+void replayStart(uint32_t seed, int folder, int mode);
+void replayStep(uint8_t button);
+void replayPress(uint8_t button);
+void replayFlush();
+void replayFinish(int score);
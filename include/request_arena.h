@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WebServer.h>
+
+// Per-request scratch memory for JSON and HTTP work.
+//
+// Request handlers open a RequestScope and build their JsonDocument on
+// requestAllocator(). Everything the document allocates comes from one
+// static block by pointer bump and is released in a single reset when the
+// outermost scope ends, so request handling never touches the general heap
+// and cannot fragment it.
+//
+// Peak usage is tracked per scope tag (the request type) and served on
+// GET /arena. Running out of arena never falls back to the heap: the
+// allocation fails, ArduinoJson reports NoMemory / overflowed(), and the
+// exhaustion is counted and logged.
+
+const size_t REQUEST_ARENA_SIZE = 4096;
+const int REQUEST_ARENA_TAGS = 8;
+
+struct RequestArenaTag
+{
+    const char *tag;
+    uint32_t requests;
+    uint32_t peakBytes;
+    uint32_t exhaustions;
+};
+
+void requestArenaBegin(WebServer &server);
+ArduinoJson::Allocator *requestAllocator();
+const RequestArenaTag *requestArenaTag(int index); // nullptr past the last tag in use
+
+// Scopes may nest (e.g. a handler calling a helper that opens its own);
+// only the outermost one resets the arena.
+class RequestScope
+{
+public:
+    explicit RequestScope(const char *tag);
+    ~RequestScope();
+
+    RequestScope(const RequestScope &) = delete;
+    RequestScope &operator=(const RequestScope &) = delete;
+
+private:
+    const char *tag_;
+    uint32_t failuresAtStart_;
+};
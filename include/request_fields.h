@@ -0,0 +1,119 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stdlib.h>
+
+// Field checks for the web app's /esp-login and /set-volume bodies, run on
+// the decoded document before anything is queued or played. ArduinoJson
+// only, no Arduino calls, so tools/fuzz_requests.cpp runs the same checks.
+
+const int VOLUME_MAX = 30; // DFPlayer volume range is 0..30
+
+// SD card folders the sound menu offers: Classic, Dogs, Cats, Harp, Violin.
+const int SOUND_FOLDERS[] = {1, 3, 4, 5, 6};
+
+enum FieldCheck
+{
+    FIELDS_OK,
+    FIELDS_BAD_VOLUME,
+    FIELDS_BAD_SOUND,
+    FIELDS_BAD_USER,
+};
+
+// Reply text for each rejection.
+const char *const FIELD_CHECK_ERRORS[] = {"", "Volume must be between 0 and 30", "Unknown sound",
+                                          "user_id must be a positive integer and username non-empty"};
+
+struct LoginFields
+{
+    long userId;          // > 0
+    const char *username; // points into the document, never empty
+    int volume;           // 0..VOLUME_MAX, or -1 when absent: keep the current volume
+    int folder;           // one of SOUND_FOLDERS, or 0 when absent: ask on the device
+};
+
+inline bool soundFolderValid(int folder)
+{
+    for (int valid : SOUND_FOLDERS)
+    {
+        if (folder == valid)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A positive integer, or a string of digits holding one (older web apps).
+// 0 when the id is missing or anything else.
+inline long parseUserId(JsonVariantConst id)
+{
+    if (id.is<long>())
+    {
+        return id.as<long>() > 0 ? id.as<long>() : 0;
+    }
+    const char *text = id.as<const char *>();
+    if (!text || *text < '1' || *text > '9')
+    {
+        return 0;
+    }
+    for (const char *p = text; *p; p++)
+    {
+        if (*p < '0' || *p > '9' || p - text >= 9) // fits a 32-bit long
+        {
+            return 0;
+        }
+    }
+    return strtol(text, nullptr, 10);
+}
+
+inline bool volumeValid(JsonVariantConst volume)
+{
+    return volume.is<int>() && volume.as<int>() >= 0 && volume.as<int>() <= VOLUME_MAX;
+}
+
+// {"user_id": 42, "username": "...", "volume": 20, "sound": 3}; user_id
+// and username are required, volume and sound are optional, but present
+// ones must be in range.
+inline FieldCheck checkLoginFields(const JsonDocument &doc, LoginFields &fields)
+{
+    fields.userId = parseUserId(doc["user_id"]);
+    fields.username = doc["username"] | "";
+    fields.volume = -1;
+    fields.folder = 0;
+    if (fields.userId == 0 || fields.username[0] == '\0')
+    {
+        return FIELDS_BAD_USER; // a score would be uploaded for user 0
+    }
+
+    JsonVariantConst volume = doc["volume"];
+    if (!volume.isNull())
+    {
+        if (!volumeValid(volume))
+        {
+            return FIELDS_BAD_VOLUME;
+        }
+        fields.volume = volume.as<int>();
+    }
+    JsonVariantConst sound = doc["sound"];
+    if (!sound.isNull())
+    {
+        if (!sound.is<int>() || !soundFolderValid(sound.as<int>()))
+        {
+            return FIELDS_BAD_SOUND;
+        }
+        fields.folder = sound.as<int>();
+    }
+    return FIELDS_OK;
+}
+
+// {"volume": 20}; the volume is required.
+inline FieldCheck checkVolumeFields(const JsonDocument &doc, int &volume)
+{
+    if (!volumeValid(doc["volume"]))
+    {
+        return FIELDS_BAD_VOLUME;
+    }
+    volume = doc["volume"].as<int>();
+    return FIELDS_OK;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Fixed-capacity player sessions with a FIFO queue.
+//
+// The web app logs players in with /esp-login, which only enqueues them. A
+// logged-in player stays current from game to game, with their own volume
+// and sound folder, until they log out (/esp-logout), leave the start
+// screen idle for too long, or finish a game while someone is queued; the
+// game then promotes the next queued player, so a hand-over needs no
+// re-login and no blocking web prompt.
+
+const int SESSION_CAPACITY = 8;
+const int SESSION_NAME_LEN = 24;
+
+struct Session
+{
+    long userId;
+    char username[SESSION_NAME_LEN + 1];
+    int volume; // 0..30, or -1 to keep the current volume
+    int folder; // DFPlayer folder, or 0 to ask on the device
+};
+
+// Returned by sessionEnqueue() for the player who is already playing.
+const int SESSION_PLAYING = -1;
+
+// Returns the 1-based queue position, or 0 if the queue is full. A player
+// who is already queued (or playing) keeps their place and only has their
+// name, volume and sound updated, so a repeated login takes no new slot.
+int sessionEnqueue(long userId, const char *username, int volume, int folder);
+
+// Current player, or nullptr when playing as a guest.
+Session *sessionActive();
+
+// Ends the active session (if any) and promotes the next queued player.
+// Returns the new active session, or nullptr if nobody was waiting.
+Session *sessionAdvance();
+
+// Logs a player out: ends their session, or takes them out of the queue.
+// False if they were neither playing nor queued.
+bool sessionLogout(long userId);
+
+int sessionWaiting();
+const Session *sessionPeek(int position); // 0 = next in line
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Operator settings that survive a reboot: sound folder, volume, game
+// mode, difficulty target and the answer to "Login via Web?".
+//
+// settingsLoad() reads them once at boot, as one NVS blob, into a RAM
+// copy; everything else reads the copy. The setters only change the copy
+// and mark it dirty; settingsPoll() writes it back once it has been left
+// alone for SETTINGS_WRITE_DELAY_MS, so a burst of changes (a menu pass,
+// a few volume requests) costs one flash write. settingsPoll() is called
+// from serviceNetwork(), which never runs inside a round, so the write (a
+// few ms, more when NVS has to erase a page) can't stall a game. A change
+// made less than SETTINGS_WRITE_DELAY_MS before power is cut is lost.
+//
+// With a sound folder and a login answer on record, setup() skips the boot
+// prompts and goes straight to the start screen. The time from reset to
+// that screen is recorded once per boot as bootToPlayableMs.
+//
+// GET /settings returns the settings as JSON. ?login=ask|web|offline
+// changes the login answer first; "ask" brings the boot prompts back.
+
+enum LoginPreference : uint8_t
+{
+    LOGIN_ASK, // no answer yet: prompt at boot
+    LOGIN_WEB,
+    LOGIN_OFFLINE,
+};
+
+struct DeviceSettings
+{
+    uint32_t magic;
+    uint8_t folder; // 0 = never chosen
+    uint8_t volume; // 0 .. 30
+    uint8_t mode;   // GameModeId
+    uint8_t login;  // LoginPreference
+    float difficultyTarget; // 0 = the engine's default
+};
+
+const uint8_t SETTINGS_DEFAULT_VOLUME = 25;
+const unsigned long SETTINGS_WRITE_DELAY_MS = 5000;
+
+// Reads NVS; defaults when nothing valid is stored. Call once, early in setup().
+void settingsLoad();
+
+// Registers GET /settings.
+void settingsBegin(WebServer &server);
+
+const DeviceSettings &settings();
+bool settingsRestored(); // settingsLoad() found a stored copy
+
+void settingsSetFolder(int folder);
+void settingsSetVolume(int volume); // cabinet default: on-device settings only, not /set-volume
+void settingsSetMode(int mode);
+void settingsSetDifficultyTarget(float target);
+void settingsSetLogin(LoginPreference login);
+
+// Writes pending changes once they have settled. Never call mid-round.
+void settingsPoll();
+
+// The start screen is up; records bootToPlayableMs the first time.
+void settingsMarkPlayable();
+unsigned long settingsBootToPlayableMs();
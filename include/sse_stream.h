@@ -0,0 +1,119 @@
+#pragma once
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+// The telemetry stream's framing and per-subscriber send queue, kept free
+// of Arduino calls so the host benchmark (tools/telemetry_bench.cpp) runs
+// exactly what the firmware runs; telemetry.cpp supplies the sockets.
+
+// Events of one frame, coalesced as "R3,3;S0,2;S1,4".
+template <int Size>
+class SseFrame
+{
+public:
+    // False when the event does not fit; flush with message() and retry.
+    bool append(char code, const int *fields, int count)
+    {
+        char text[40];
+        int n = snprintf(text, sizeof(text), "%c", code);
+        for (int i = 0; i < count; i++)
+        {
+            n += snprintf(text + n, sizeof(text) - n, i == 0 ? "%d" : ",%d", fields[i]);
+        }
+        if (length_ + n + 1 > Size)
+        {
+            return false;
+        }
+        if (length_ > 0)
+        {
+            text_[length_++] = ';';
+        }
+        memcpy(text_ + length_, text, n);
+        length_ += n;
+        return true;
+    }
+
+    bool empty() const { return length_ == 0; }
+    void clear() { length_ = 0; }
+
+    // Writes "data: <events>\n\n" into out (at least MESSAGE_SIZE bytes)
+    // and empties the frame. Returns the message length.
+    int message(char *out)
+    {
+        int n = snprintf(out, MESSAGE_SIZE, "data: %.*s\n\n", length_, text_);
+        length_ = 0;
+        return n;
+    }
+
+    static const int MESSAGE_SIZE = Size + 16;
+
+private:
+    char text_[Size];
+    int length_ = 0;
+};
+
+enum SseDrain
+{
+    SSE_DRAINED,
+    SSE_WOULD_BLOCK, // socket buffer full, try again next frame
+    SSE_CLOSED,
+};
+
+// Bytes waiting to go to one subscriber. Never grows: a subscriber whose
+// queue overflows gets dropped by the caller instead of stalling the game.
+template <int Size>
+class SseQueue
+{
+public:
+    // False if the bytes do not fit.
+    bool enqueue(const char *data, int length)
+    {
+        if (head_ > 0 && tail_ + length > Size)
+        {
+            // Compact the unsent bytes to the front before appending.
+            memmove(queue_, queue_ + head_, tail_ - head_);
+            tail_ -= head_;
+            head_ = 0;
+        }
+        if (tail_ + length > Size)
+        {
+            return false;
+        }
+        memcpy(queue_ + tail_, data, length);
+        tail_ += length;
+        return true;
+    }
+
+    // Pushes as much as send(data, length) accepts right now. send behaves
+    // like a non-blocking send(): bytes sent, or < 0 with errno set.
+    template <class Send>
+    SseDrain drain(Send send)
+    {
+        while (head_ < tail_)
+        {
+            int sent = send(queue_ + head_, tail_ - head_);
+            if (sent > 0)
+            {
+                head_ += sent;
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return SSE_WOULD_BLOCK;
+            }
+            return SSE_CLOSED;
+        }
+        head_ = tail_ = 0;
+        return SSE_DRAINED;
+    }
+
+    int pending() const { return tail_ - head_; }
+    void clear() { head_ = tail_ = 0; }
+
+private:
+    char queue_[Size];
+    int head_ = 0; // next byte to send
+    int tail_ = 0; // next free byte
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Live game telemetry pushed to web clients as Server-Sent Events on /events.
+//
+// Game code calls telemetryEmit() as things happen. Events are buffered for
+// the current frame and telemetryPoll() coalesces them into a single SSE
+// message, e.g.
+//
+//     data: R3,3;S0,2;S1,4;S2,0
+//
+// Event codes (fields are comma separated, events separated by ';'):
+//     R<round>,<sequenceLength>     round start
+//     S<index>,<button>             Simon plays one step
+//     P<button>,<reactionMs>,<ok>   player press (ok = 1 if correct)
+//     C<score>                      score changed
+//     G<finalScore>                 game over
+//
+// Every subscriber has a bounded send queue that is drained with
+// non-blocking socket writes. A client whose queue overflows is dropped so
+// a slow browser can never stall the game loop. The framing and the queue
+// live in sse_stream.h so tools/telemetry_bench.cpp can measure them on
+// the host with 20 subscribers.
+
+enum TelemetryEvent : char
+{
+    TELEMETRY_ROUND_START = 'R',
+    TELEMETRY_SIMON_STEP = 'S',
+    TELEMETRY_PRESS = 'P',
+    TELEMETRY_SCORE = 'C',
+    TELEMETRY_GAME_OVER = 'G',
+};
+
+const int TELEMETRY_MAX_SUBSCRIBERS = 4;
+const int TELEMETRY_QUEUE_SIZE = 512; // bytes per subscriber
+const int TELEMETRY_FRAME_SIZE = 192; // bytes of events coalesced per frame
+
+void telemetryBegin(WebServer &server);
+void telemetryEmit(TelemetryEvent event, int a);
+void telemetryEmit(TelemetryEvent event, int a, int b);
+void telemetryEmit(TelemetryEvent event, int a, int b, int c);
+void telemetryPoll();
+int telemetrySubscriberCount();
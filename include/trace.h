@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Timeline tracing in the Chrome trace-event format.
+//
+//     void playInFolder(int fold, int track)
+//     {
+//         TraceScope trace(TRACE_PLAY_IN_FOLDER, track);
+//         ...
+//     }
+//
+// Begin/end pairs (TraceScope, or traceEnter/traceLeave when the two ends
+// are in different functions) and instant events (traceInstant) go into a
+// fixed flight-recorder ring: each event is 16 bytes with a microsecond
+// timestamp, the core it ran on and one integer argument. Writers claim a
+// slot with one atomic increment and never wait; when the ring is full the
+// oldest events are overwritten, so the ring always holds the last
+// TRACE_RING_SIZE events.
+//
+// GET /trace streams the ring as trace JSON, event by event through a
+// small chunk buffer, for chrome://tracing or ui.perfetto.dev. One thread
+// per core. ?clear=1 empties the ring, e.g. right before the round you
+// want to look at.
+//
+// Build with -DSIMON_TRACE to enable; otherwise every call compiles to
+// nothing and the ring takes no RAM. Timestamps are stored as the low 32
+// bits of the microsecond clock and unwrapped against the newest event, so
+// events more than 71 minutes older than it show wrong times.
+
+#ifdef SIMON_TRACE
+constexpr bool TRACE_ENABLED = true;
+#else
+constexpr bool TRACE_ENABLED = false;
+#endif
+
+enum TraceName : uint16_t
+{
+    TRACE_SIMON_TURN,
+    TRACE_PLAYER_TURN,
+    TRACE_PLAYER_PRESS,
+    TRACE_PLAY_IN_FOLDER,
+    TRACE_EXECUTE_CMD,
+    TRACE_UPDATE_LCD,
+    TRACE_HTTP_REQUEST,
+    TRACE_SUBMIT_SCORE,
+    TRACE_SCORE_POST,
+    TRACE_ROUND_START, // instant, arg = sequence length
+    TRACE_GAME_OVER,   // instant, arg = score
+    TRACE_WIFI_LOST,   // instant
+    TRACE_WIFI_UP,     // instant, arg = connect time in ms
+    TRACE_NAME_COUNT,
+};
+
+const int TRACE_RING_SIZE = 512;
+
+void traceRecord(TraceName name, char phase, uint32_t arg);
+
+inline void traceEnter(TraceName name, uint32_t arg = 0)
+{
+    if (TRACE_ENABLED)
+    {
+        traceRecord(name, 'B', arg);
+    }
+}
+
+inline void traceLeave(TraceName name)
+{
+    if (TRACE_ENABLED)
+    {
+        traceRecord(name, 'E', 0);
+    }
+}
+
+inline void traceInstant(TraceName name, uint32_t arg = 0)
+{
+    if (TRACE_ENABLED)
+    {
+        traceRecord(name, 'i', arg);
+    }
+}
+
+class TraceScope
+{
+public:
+    explicit TraceScope(TraceName name, uint32_t arg = 0) : name_(name) { traceEnter(name, arg); }
+    ~TraceScope() { traceLeave(name_); }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    TraceName name_;
+};
+
+// Registers GET /trace (?clear=1 empties the ring).
+void traceBegin(WebServer &server);
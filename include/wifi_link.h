@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Background Wi-Fi connection manager.
+//
+// wifiBegin() only starts the first attempt; wifiPoll() must be called
+// regularly from the main loop and the wait loops between games. It never
+// blocks: it checks the link state, times out stalled attempts and
+// schedules retries with exponential backoff.
+//
+// Starting an attempt reconfigures the Wi-Fi driver, and the caller pings
+// the backend when the link comes up, so neither happens mid-round: game
+// loops call wifiWatch() instead, which only notices a dropped link (so
+// wifiConnected() stays truthful) and leaves the reconnect to the next
+// wifiPoll().
+//
+// The BSSID, channel and IP lease of the last good connection are cached in
+// NVS. Reconnects first try that cache (no scan, no DHCP) and fall back to a
+// full scan + DHCP connect if the fast attempt does not come up in time.
+// wifiPoll() only captures the new link in RAM; wifiFlushCache() writes it
+// to NVS and must be called between games.
+
+enum WifiState
+{
+    WIFI_LINK_IDLE,
+    WIFI_LINK_CONNECTING,
+    WIFI_LINK_CONNECTED,
+    WIFI_LINK_BACKOFF,
+};
+
+struct WifiStats
+{
+    unsigned long firstConnectMs;  // boot-time connect duration, 0 until connected
+    unsigned long lastConnectMs;   // duration of the most recent successful attempt
+    unsigned long lastReconnectMs; // link drop to link up, 0 until a reconnect happened
+    uint32_t reconnects;
+    uint32_t failedAttempts;
+    bool lastAttemptUsedCache;
+};
+
+void wifiBegin(const char *ssid, const char *password);
+
+// Returns true exactly once each time the link comes up.
+bool wifiPoll();
+
+// Mid-round variant of wifiPoll(): marks a lost link down, touches nothing else.
+void wifiWatch();
+
+// Writes a link captured by wifiPoll() to NVS. Never call mid-round.
+void wifiFlushCache();
+
+bool wifiConnected();
+WifiState wifiState();
+const WifiStats &wifiStats();
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ArduinoJson.h>
+
+// The Arduino-free half of wire_format.h: the formats and the document
+// encode/decode the device uses, so the host tools (tools/fuzz_requests.cpp)
+// decode request bodies exactly as the handlers do.
+
+enum WireFormat
+{
+    WIRE_JSON,
+    WIRE_MSGPACK,
+};
+
+const int WIRE_MAX_BODY = 512;
+
+inline DeserializationError wireDecode(JsonDocument &doc, const uint8_t *data, size_t length, WireFormat format)
+{
+    if (format == WIRE_MSGPACK)
+    {
+        return deserializeMsgPack(doc, data, length);
+    }
+    return deserializeJson(doc, data, length);
+}
+
+// Returns the encoded length, or 0 (and writes nothing) when doc does not
+// fit in capacity bytes.
+inline size_t wireEncode(const JsonDocument &doc, uint8_t *out, size_t capacity, WireFormat format)
+{
+    if (format == WIRE_MSGPACK)
+    {
+        return measureMsgPack(doc) <= capacity ? serializeMsgPack(doc, out, capacity) : 0;
+    }
+    // serializeJson() also writes a terminating NUL
+    return measureJson(doc) < capacity ? serializeJson(doc, (char *)out, capacity) : 0;
+}
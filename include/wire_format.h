@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WebServer.h>
+#include "wire_codec.h"
+
+// Encoding of the small messages exchanged with the web app and backend
+// (login, volume, score). JSON stays the default; MessagePack is the compact
+// binary alternative, negotiated through Content-Type / Accept headers:
+// requests are decoded by their Content-Type, replies are MessagePack when
+// the client's Accept lists it and JSON otherwise.
+
+const char *wireContentType(WireFormat format);
+WireFormat wireFormatFromContentType(const String &contentType);
+bool wireAccepts(const String &acceptHeader, WireFormat format);
+
+// Raw-body callback for server.on(uri, method, handler, rawHandler).
+// WebServer hands non-form bodies to it in chunks; collecting them here
+// keeps binary bodies intact (arg("plain") stops at the first NUL byte).
+void wireCaptureBody(HTTPRaw &raw);
+size_t wireBodyLength();
+
+// Decode the captured body of the current request using its Content-Type.
+DeserializationError wireDecodeRequest(WebServer &server, JsonDocument &doc);
+
+// Send doc in the format the request's Accept header asks for. Replies that
+// can outgrow WIRE_MAX_BODY pass their own encode buffer.
+void wireRespond(WebServer &server, int code, const JsonDocument &doc);
+void wireRespond(WebServer &server, int code, const JsonDocument &doc, uint8_t *buffer, size_t capacity);
@@ -0,0 +1,88 @@
+"""Compare a Google Benchmark JSON run against the committed baseline.
+
+    python3 scripts/bench_compare.py tools/bench_baseline.json bench.json [--threshold 0.15]
+    python3 scripts/bench_compare.py tools/bench_baseline.json bench.json --update
+
+Prints the relative change of every benchmark's CPU time (the median when
+the runs used --benchmark_repetitions) and exits with status 1 if any got slower than the baseline by more than the threshold.
+Benchmarks present in only one file are listed but never fail the run.
+
+--update rewrites the baseline from the current run, keeping only the
+context and one row per benchmark so the committed file stays small.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """CPU time per benchmark: the median when the run has repetitions, else the single run."""
+    with open(path) as f:
+        data = json.load(f)
+    runs = {}
+    medians = {}
+    for bench in data["benchmarks"]:
+        name = bench.get("run_name", bench["name"])
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = bench["cpu_time"], bench["time_unit"]
+        else:
+            runs.setdefault(name, (bench["cpu_time"], bench["time_unit"]))
+    runs.update(medians)
+    return runs
+
+
+def save(path, source, results):
+    with open(source) as f:
+        context = json.load(f)["context"]
+    rows = [{"name": name, "run_type": "aggregate", "aggregate_name": "median",
+             "cpu_time": cpu, "time_unit": unit} for name, (cpu, unit) in sorted(results.items())]
+    with open(path, "w") as f:
+        json.dump({"context": context, "benchmarks": rows}, f, indent=1)
+        f.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.15,
+                        help="allowed slowdown as a fraction (default 0.15)")
+    parser.add_argument("--update", action="store_true",
+                        help="replace the baseline with the current run")
+    args = parser.parse_args()
+
+    current = load(args.current)
+    if args.update:
+        save(args.baseline, args.current, current)
+        print("baseline %s updated with %d benchmarks" % (args.baseline, len(current)))
+        return 0
+    baseline = load(args.baseline)
+
+    regressions = 0
+    width = max(len(name) for name in baseline.keys() | current.keys())
+    for name in sorted(baseline.keys() | current.keys()):
+        if name not in current:
+            print("%-*s  missing from current run" % (width, name))
+            continue
+        if name not in baseline:
+            print("%-*s  new, %.1f %s" % (width, name, current[name][0], current[name][1]))
+            continue
+        (old, unit), (new, _) = baseline[name], current[name]
+        change = (new - old) / old
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-*s  %10.1f -> %10.1f %s  %+6.1f%%%s" % (width, name, old, new, unit, 100 * change, flag))
+
+    if regressions:
+        print("\n%d benchmark(s) slower than baseline by more than %.0f%%" % (regressions, 100 * args.threshold))
+        return 1
+    print("\nno regressions beyond %.0f%%" % (100 * args.threshold))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+"""Pre-build step: gzip web/index.html into a flash-resident C array.
+
+Writes include/web_assets.h with the compressed page, its length and a
+strong ETag derived from the uncompressed content. The header is only
+rewritten when the page changes, so unchanged builds stay incremental.
+
+Runs automatically through `extra_scripts` in platformio.ini and can also
+be run by hand: python scripts/embed_web.py
+"""
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE = os.path.join(PROJECT_DIR, "web", "index.html")
+TARGET = os.path.join(PROJECT_DIR, "include", "web_assets.h")
+
+
+def render(html):
+    # mtime=0 keeps the output byte-identical for identical input.
+    compressed = gzip.compress(html, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(html).hexdigest()[:16]
+
+    lines = [
+        "#pragma once",
+        "",
+        "// Generated by scripts/embed_web.py from web/index.html - do not edit.",
+        "",
+        "#include <Arduino.h>",
+        "",
+        'const char INDEX_HTML_ETAG[] = "\\"%s\\"";' % etag,
+        "const size_t INDEX_HTML_GZ_LEN = %d;" % len(compressed),
+        "const size_t INDEX_HTML_RAW_LEN = %d;" % len(html),
+        "const uint8_t INDEX_HTML_GZ[] PROGMEM = {",
+    ]
+    for i in range(0, len(compressed), 16):
+        chunk = compressed[i:i + 16]
+        lines.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    lines.append("};")
+    return "\n".join(lines) + "\n", len(html), len(compressed)
+
+
+def main():
+    with open(SOURCE, "rb") as f:
+        html = f.read()
+    header, raw_len, gz_len = render(html)
+
+    if os.path.exists(TARGET):
+        with open(TARGET) as f:
+            if f.read() == header:
+                return
+    with open(TARGET, "w") as f:
+        f.write(header)
+    print("embed_web: index.html %d -> %d bytes gzip" % (raw_len, gz_len))
+
+
+main()
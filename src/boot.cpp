@@ -0,0 +1,275 @@
+#include "boot.h"
+
+#include <atomic>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
+#include "metrics.h"
+
+namespace
+{
+    const UBaseType_t BOOT_TASK_PRIORITY = 1; // same as loopTask
+    const int MAX_EVENT_GROUP_BITS = 24;
+    static_assert(BOOT_MAX_STEPS <= MAX_EVENT_GROUP_BITS, "one event group bit per step");
+
+    struct StepContext
+    {
+        const BootStep *step;
+        int index;
+        EventGroupHandle_t done;
+    };
+
+    // Outlive bootRun(): a step that timed out may still be running.
+    StepContext contexts[BOOT_MAX_STEPS];
+    BootEvent events[BOOT_MAX_EVENTS];
+    std::atomic<int> claimed{0};
+    WebServer *bootServer = nullptr;
+
+    // BOOT_ON_CALLER steps whose dependencies missed BOOT_TIMEOUT_MS; bootPoll() runs them.
+    const BootStep *lateSteps = nullptr;
+    int lateCount = 0;
+    uint32_t latePending = 0;
+    EventGroupHandle_t lateDone = nullptr;
+
+    void printSteps(const BootStep *steps, int count, uint32_t bits)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (bits & BOOT_AFTER(i))
+            {
+                Serial.printf(" %s", steps[i].name);
+            }
+        }
+        Serial.println();
+    }
+
+    void record(const char *name, uint32_t startUs, uint32_t endUs)
+    {
+        int index = claimed.fetch_add(1, std::memory_order_relaxed);
+        if (index < BOOT_MAX_EVENTS)
+        {
+            events[index] = {name, startUs, endUs, (uint8_t)xPortGetCoreID()};
+        }
+    }
+
+    void runStep(const BootStep &step, int index, EventGroupHandle_t done)
+    {
+        uint32_t startUs = esp_timer_get_time();
+        step.run();
+        record(step.name, startUs, esp_timer_get_time());
+        xEventGroupSetBits(done, BOOT_AFTER(index)); // publishes the event to whoever waits on it
+    }
+
+    // FreeRTOS can't wait for "no bits", so steps without dependencies don't wait.
+    bool waitFor(EventGroupHandle_t done, uint32_t bits, TickType_t ticks)
+    {
+        if (bits == 0)
+        {
+            return true;
+        }
+        return (xEventGroupWaitBits(done, bits, pdFALSE, pdTRUE, ticks) & bits) == bits;
+    }
+
+    void stepTask(void *arg)
+    {
+        StepContext *context = (StepContext *)arg;
+        waitFor(context->done, context->step->after, portMAX_DELAY);
+        runStep(*context->step, context->index, context->done);
+        vTaskDelete(nullptr);
+    }
+
+    TickType_t ticksLeft(unsigned long startedAt)
+    {
+        unsigned long elapsed = millis() - startedAt;
+        return elapsed < BOOT_TIMEOUT_MS ? pdMS_TO_TICKS(BOOT_TIMEOUT_MS - elapsed) : 0;
+    }
+
+    // Events in start order, marks before the step that starts with them.
+    int sortedEvents(int *order)
+    {
+        int count = bootEventCount();
+        for (int i = 0; i < count; i++)
+        {
+            int j = i;
+            for (; j > 0 && events[order[j - 1]].startUs > events[i].startUs; j--)
+            {
+                order[j] = order[j - 1];
+            }
+            order[j] = i;
+        }
+        return count;
+    }
+
+    void handleBoot()
+    {
+        bootServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        bootServer->send(200, "application/json", "");
+        char line[192];
+        snprintf(line, sizeof(line), "{\"firstScreenMs\":%.1f,\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                                     "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"boot\"}}",
+                 bootMarkUs(BOOT_MARK_FIRST_SCREEN) / 1000.0);
+        bootServer->sendContent(line);
+
+        int order[BOOT_MAX_EVENTS];
+        int count = sortedEvents(order);
+        for (int i = 0; i < count; i++)
+        {
+            const BootEvent &event = events[order[i]];
+            if (event.endUs == event.startUs)
+            {
+                snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%lu,\"pid\":1,\"tid\":%u}",
+                         event.name, (unsigned long)event.startUs, (unsigned)event.core);
+            }
+            else
+            {
+                snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%u}",
+                         event.name, (unsigned long)event.startUs, (unsigned long)(event.endUs - event.startUs),
+                         (unsigned)event.core);
+            }
+            bootServer->sendContent(line);
+        }
+        bootServer->sendContent("\n]}\n");
+        bootServer->sendContent("", 0); // last chunk
+    }
+}
+
+bool bootRun(const BootStep *steps, int count)
+{
+    if (count > BOOT_MAX_STEPS)
+    {
+        Serial.printf("❌ %d boot steps, only %d fit; the rest are skipped\n", count, BOOT_MAX_STEPS);
+        count = BOOT_MAX_STEPS;
+    }
+    unsigned long startedAt = millis();
+    EventGroupHandle_t done = xEventGroupCreate();
+    bool onCaller[BOOT_MAX_STEPS];
+
+    for (int i = 0; i < count; i++)
+    {
+        onCaller[i] = steps[i].where == BOOT_ON_CALLER;
+        if (!onCaller[i])
+        {
+            contexts[i] = {&steps[i], i, done};
+            // A step whose task can't be created runs on the caller instead
+            onCaller[i] = xTaskCreatePinnedToCore(stepTask, steps[i].name, BOOT_TASK_STACK, &contexts[i],
+                                                  BOOT_TASK_PRIORITY, nullptr, tskNO_AFFINITY) != pdPASS;
+        }
+    }
+
+    uint32_t all = (uint32_t)((1ull << count) - 1);
+    uint32_t late = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (!onCaller[i])
+        {
+            continue;
+        }
+        if (waitFor(done, steps[i].after, ticksLeft(startedAt)))
+        {
+            runStep(steps[i], i, done);
+            continue;
+        }
+        // Not skipped: bootPoll() runs it from the loop once these finish
+        late |= BOOT_AFTER(i);
+        Serial.printf("⏳ Boot step %s deferred, still waiting for:", steps[i].name);
+        printSteps(steps, count, steps[i].after & ~xEventGroupGetBits(done));
+    }
+
+    if (!waitFor(done, all, ticksLeft(startedAt)))
+    {
+        Serial.print("❌ Boot steps not finished after timeout:");
+        printSteps(steps, count, all & ~xEventGroupGetBits(done));
+        lateSteps = steps;
+        lateCount = count;
+        lateDone = done; // the event group stays: late steps still set their bit
+        latePending = late;
+        return false;
+    }
+    vEventGroupDelete(done);
+    return true;
+}
+
+bool bootPoll()
+{
+    if (!latePending)
+    {
+        return true;
+    }
+    for (int i = 0; i < lateCount; i++)
+    {
+        uint32_t after = lateSteps[i].after;
+        if ((latePending & BOOT_AFTER(i)) && (xEventGroupGetBits(lateDone) & after) == after)
+        {
+            latePending &= ~BOOT_AFTER(i);
+            Serial.printf("⏳ Boot step %s running late, %lu ms after boot\n", lateSteps[i].name, millis());
+            runStep(lateSteps[i], i, lateDone);
+        }
+    }
+    return latePending == 0;
+}
+
+void bootMark(const char *name)
+{
+    uint32_t now = esp_timer_get_time();
+    record(name, now, now);
+}
+
+int bootEventCount()
+{
+    int count = claimed.load(std::memory_order_relaxed);
+    return count < BOOT_MAX_EVENTS ? count : BOOT_MAX_EVENTS;
+}
+
+const BootEvent &bootEvent(int index)
+{
+    return events[index];
+}
+
+uint32_t bootMarkUs(const char *name)
+{
+    for (int i = 0; i < bootEventCount(); i++)
+    {
+        if (events[i].endUs == events[i].startUs && strcmp(events[i].name, name) == 0)
+        {
+            return events[i].startUs;
+        }
+    }
+    return 0;
+}
+
+void bootPrint(Print &out)
+{
+    int order[BOOT_MAX_EVENTS];
+    int count = sortedEvents(order);
+    out.println("⏱️ Boot timeline (ms since app start):");
+    out.println("     start      end     took  core  step");
+    for (int i = 0; i < count; i++)
+    {
+        const BootEvent &event = events[order[i]];
+        if (event.endUs == event.startUs)
+        {
+            out.printf("  %8.1f                    %u  ● %s\n", event.startUs / 1000.0, (unsigned)event.core, event.name);
+        }
+        else
+        {
+            out.printf("  %8.1f %8.1f %8.1f    %u  %s\n", event.startUs / 1000.0, event.endUs / 1000.0,
+                       (event.endUs - event.startUs) / 1000.0, (unsigned)event.core, event.name);
+        }
+    }
+
+    uint32_t firstScreenUs = bootMarkUs(BOOT_MARK_FIRST_SCREEN);
+    if (firstScreenUs)
+    {
+        bool onBudget = firstScreenUs <= BOOT_FIRST_SCREEN_BUDGET_MS * 1000;
+        out.printf("%s First screen after %.1f ms (budget %lu ms)\n", onBudget ? "✅" : "⚠️", firstScreenUs / 1000.0,
+                   BOOT_FIRST_SCREEN_BUDGET_MS);
+    }
+}
+
+void bootBegin(WebServer &server)
+{
+    bootServer = &server;
+    metricsOn(server, "/boot", HTTP_GET, handleBoot);
+}
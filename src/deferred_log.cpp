@@ -0,0 +1,92 @@
+#include "deferred_log.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "memory_telemetry.h"
+#include "mpsc_ring.h"
+
+namespace
+{
+    const uint32_t DRAIN_STACK_BYTES = 3072;
+    const UBaseType_t DRAIN_PRIORITY = 1;
+    const BaseType_t DRAIN_CORE = 0; // the game loop runs on core 1
+
+    MpscRing<LogRecord, LOG_RING_SIZE> ring;
+    uint32_t droppedReported = 0;
+
+    // 64-bit time of a record, assuming it was logged less than 71 minutes ago.
+    uint64_t recordTimeUs(const LogRecord &record)
+    {
+        uint64_t now = esp_timer_get_time();
+        return now - (uint32_t)((uint32_t)now - record.atUs);
+    }
+
+    void write(const LogRecord &record)
+    {
+#ifdef SIMON_LOG_BINARY
+        uint8_t frame[LOG_FRAME_SIZE];
+        logEncodeFrame(frame, record);
+        Serial.write(frame, sizeof(frame));
+#else
+        uint64_t atUs = recordTimeUs(record);
+        char line[160];
+        int prefix = snprintf(line, sizeof(line), "[%6lu.%03lu] ", (unsigned long)(atUs / 1000000),
+                              (unsigned long)(atUs / 1000 % 1000));
+        size_t length = prefix + logFormat(line + prefix, sizeof(line) - prefix - 1, record);
+        line[length++] = '\n';
+        Serial.write((const uint8_t *)line, length);
+#endif
+    }
+
+    void drain()
+    {
+        LogRecord record;
+        while (ring.pop(record))
+        {
+            write(record);
+        }
+
+        uint32_t dropped = ring.dropped();
+        if (dropped != droppedReported)
+        {
+            LogRecord report = {(uint32_t)esp_timer_get_time(), LOG_DROPPED, 1, 0, {dropped - droppedReported}};
+            droppedReported = dropped;
+            write(report);
+        }
+    }
+
+    void drainTask(void *)
+    {
+        for (;;)
+        {
+            drain();
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+        }
+    }
+}
+
+void logPush(LogId id, const uint32_t *args, uint8_t argc)
+{
+    LogRecord record;
+    record.atUs = (uint32_t)esp_timer_get_time();
+    record.id = id;
+    record.argc = argc;
+    record.reserved = 0;
+    memcpy(record.args, args, sizeof(record.args));
+    ring.push(record);
+}
+
+void logBegin()
+{
+    TaskHandle_t task = nullptr;
+    xTaskCreatePinnedToCore(drainTask, "logDrain", DRAIN_STACK_BYTES, nullptr, DRAIN_PRIORITY, &task, DRAIN_CORE);
+    memoryWatchTask("logDrain", task);
+    logDeferred<LOG_LOGGER_UP>(LOG_RING_SIZE, (unsigned)SIMON_LOG_LEVEL);
+}
+
+uint32_t logDropped()
+{
+    return ring.dropped();
+}
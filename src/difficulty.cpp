@@ -0,0 +1,130 @@
+#include "difficulty.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace
+{
+    const float UP_STEP = 0.5f;
+    const float DEFAULT_TARGET = 0.8f;
+    const float REACTION_ALPHA = 1.0f / 8; // EWMA weight of the newest press
+    const float ERROR_ALPHA = 1.0f / 16;
+
+    // Two steps per round once the player is this far up the curve and
+    // reacting well inside the step time with almost no errors.
+    const int FAST_LEVEL = 12;
+    const float FAST_REACTION_FRACTION = 0.5f;
+    const float FAST_ERROR_RATE = 0.05f;
+
+    struct TempoCurve
+    {
+        Tempo levels[DIFFICULTY_LEVELS];
+    };
+
+    // Exponential ease from the classic tempo towards the fastest playable one:
+    // each level removes 8% of the remaining headroom.
+    constexpr TempoCurve buildTempoCurve()
+    {
+        TempoCurve curve{};
+        float remaining = 1.0f;
+        for (int level = 0; level < DIFFICULTY_LEVELS; level++)
+        {
+            curve.levels[level].stepMs = (uint16_t)(200 + 600 * remaining);
+            curve.levels[level].gapMs = (uint16_t)(60 + 240 * remaining);
+            curve.levels[level].feedbackMs = (uint16_t)(120 + 180 * remaining);
+            remaining *= 0.92f;
+        }
+        return curve;
+    }
+
+    constexpr TempoCurve TEMPO_CURVE = buildTempoCurve();
+    static_assert(TEMPO_CURVE.levels[0].stepMs == 800, "level 0 must match the classic tempo");
+    static_assert(TEMPO_CURVE.levels[0].gapMs == 300, "level 0 must match the classic gap");
+
+    float clamp(float value, float low, float high)
+    {
+        return value < low ? low : (value > high ? high : value);
+    }
+}
+
+DifficultyEngine::DifficultyEngine()
+{
+    state_ = DifficultyState();
+    state_.targetSuccess = DEFAULT_TARGET;
+}
+
+void DifficultyEngine::reset()
+{
+    float target = state_.targetSuccess;
+    state_ = DifficultyState();
+    state_.targetSuccess = target;
+}
+
+void DifficultyEngine::setTarget(float targetSuccess)
+{
+    state_.targetSuccess = clamp(targetSuccess, 0.5f, 0.95f);
+}
+
+void DifficultyEngine::recordPress(unsigned long reactionMs, bool correct)
+{
+    float sample = reactionMs;
+    if (state_.presses == 0)
+    {
+        state_.reactionMeanMs = sample;
+        state_.reactionVarMs2 = 0;
+    }
+    else
+    {
+        float delta = sample - state_.reactionMeanMs;
+        state_.reactionMeanMs += REACTION_ALPHA * delta;
+        state_.reactionVarMs2 = (1 - REACTION_ALPHA) * (state_.reactionVarMs2 + REACTION_ALPHA * delta * delta);
+    }
+    state_.errorRate += ERROR_ALPHA * ((correct ? 0.0f : 1.0f) - state_.errorRate);
+    state_.presses++;
+}
+
+void DifficultyEngine::recordRound(bool cleared)
+{
+    if (cleared)
+    {
+        state_.roundsCleared++;
+        state_.level += UP_STEP;
+    }
+    else
+    {
+        state_.roundsFailed++;
+        state_.level -= UP_STEP * state_.targetSuccess / (1 - state_.targetSuccess);
+    }
+    state_.level = clamp(state_.level, 0.0f, (float)(DIFFICULTY_LEVELS - 1));
+}
+
+int DifficultyEngine::currentLevel() const
+{
+    return (int)(state_.level + 0.5f);
+}
+
+const Tempo &DifficultyEngine::tempo() const
+{
+    return TEMPO_CURVE.levels[currentLevel()];
+}
+
+int DifficultyEngine::stepsPerRound() const
+{
+    bool fast = state_.reactionMeanMs < FAST_REACTION_FRACTION * tempo().stepMs;
+    bool accurate = state_.errorRate < FAST_ERROR_RATE;
+    return currentLevel() >= FAST_LEVEL && state_.presses > 0 && fast && accurate ? 2 : 1;
+}
+
+size_t DifficultyEngine::toJson(char *out, size_t size) const
+{
+    const Tempo &current = tempo();
+    return snprintf(out, size,
+                    "{\"level\": %.2f, \"target_success\": %.2f, \"step_ms\": %u, \"gap_ms\": %u, "
+                    "\"feedback_ms\": %u, \"steps_per_round\": %d, \"reaction_mean_ms\": %.0f, "
+                    "\"reaction_stddev_ms\": %.0f, \"error_rate\": %.3f, \"presses\": %u, "
+                    "\"rounds_cleared\": %u, \"rounds_failed\": %u}",
+                    state_.level, state_.targetSuccess, current.stepMs, current.gapMs, current.feedbackMs,
+                    stepsPerRound(), state_.reactionMeanMs, sqrtf(state_.reactionVarMs2),
+                    state_.errorRate, (unsigned)state_.presses, (unsigned)state_.roundsCleared,
+                    (unsigned)state_.roundsFailed);
+}
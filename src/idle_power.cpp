@@ -0,0 +1,261 @@
+#include "idle_power.h"
+
+#include <driver/gpio.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "deferred_log.h"
+
+namespace
+{
+    // Current estimate, ESP32 datasheet figures. CPU: 240 MHz with the
+    // radio in modem sleep (30-68 mA); light sleep: 0.8 mA; receive:
+    // 95-100 mA on top. With DTIM 1 the chip wakes for every beacon
+    // (102.4 ms) and listens for about BEACON_RX_US.
+    const uint32_t CPU_ACTIVE_UA = 50000;
+    const uint32_t CPU_80MHZ_UA = 25000; // modem sleep at the power manager's lowest clock (20-31 mA)
+    const uint32_t LIGHT_SLEEP_UA = 800;
+    const uint32_t RADIO_RX_UA = 100000;
+    const uint32_t BEACON_RX_US = 3000;
+    const uint32_t DTIM_PERIOD_US = 102400;
+
+    // Lowest frequency the power manager may pick while idle; 80 MHz keeps
+    // the APB clock, and with it the UARTs and I2C, at full speed.
+    const int PM_MIN_FREQ_MHZ = 80;
+
+    const unsigned long MIN_NAP_MS = 5; // the power manager won't sleep for a shorter wait anyway
+    const int MAX_WAKE_PINS = 5;
+
+    int wakePins[MAX_WAKE_PINS];
+    int wakePinCount = 0;
+
+    esp_pm_handle_t awakeLock = nullptr; // held whenever the cabinet is not idle
+    TaskHandle_t waitingTask = nullptr;
+    volatile int64_t buttonWokeAt = 0;
+
+    IdleStats stats = {};
+    unsigned long lastActivityAt = 0;
+    bool idle = false;
+    int64_t idleSince = 0;
+    int64_t wokeAt = 0; // end of the last wait, or when idle began
+    bool buttonWakePending = false;
+    uint64_t stretchSleptUs = 0;
+    uint64_t stretchAwakeUs = 0;
+
+    // What esp_pm_configure() accepted in idleBegin().
+    bool lightSleepActive = false;
+    bool clockScalingActive = false;
+
+    // Current while the loop waits in the mode the build allows.
+    uint32_t waitingUa()
+    {
+        return lightSleepActive ? LIGHT_SLEEP_UA : clockScalingActive ? CPU_80MHZ_UA : CPU_ACTIVE_UA;
+    }
+
+    // With light sleep, assumes the chip sleeps whenever the loop is
+    // waiting, apart from the beacons: an upper bound on the saving, to
+    // check against a meter.
+    uint32_t estimateCurrentUa(uint64_t waitingUs, uint64_t awakeUs, uint32_t waitUa)
+    {
+        uint64_t totalUs = waitingUs + awakeUs;
+        if (totalUs == 0)
+        {
+            return 0;
+        }
+        uint64_t radioUs = totalUs * BEACON_RX_US / DTIM_PERIOD_US;
+        uint64_t chargeUaUs = awakeUs * CPU_ACTIVE_UA + waitingUs * waitUa + radioUs * RADIO_RX_UA;
+        return chargeUaUs / totalUs;
+    }
+
+    // Low-level interrupt on the buttons, enabled only while the loop waits.
+    // A level interrupt keeps firing while the button is down, so it masks
+    // itself; the wait unmasks the pins again.
+    void IRAM_ATTR onButtonLow()
+    {
+        for (int i = 0; i < wakePinCount; i++)
+        {
+            gpio_intr_disable((gpio_num_t)wakePins[i]);
+        }
+        buttonWokeAt = esp_timer_get_time();
+        BaseType_t woken = pdFALSE;
+        if (waitingTask)
+        {
+            vTaskNotifyGiveFromISR(waitingTask, &woken);
+        }
+        portYIELD_FROM_ISR(woken);
+    }
+
+    bool anyButtonDown()
+    {
+        for (int i = 0; i < wakePinCount; i++)
+        {
+            if (digitalRead(wakePins[i]) == LOW)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void enterIdle()
+    {
+        idle = true;
+        idleSince = wokeAt = esp_timer_get_time();
+        stretchSleptUs = stretchAwakeUs = 0;
+        logDeferred<LOG_IDLE_ENTER>();
+        // The power manager may now drop the clock and light-sleep from the
+        // idle task; Wi-Fi stays associated in modem sleep, Arduino's default.
+        esp_pm_lock_release(awakeLock);
+    }
+
+    void leaveIdle()
+    {
+        esp_pm_lock_acquire(awakeLock);
+        idle = false;
+        int64_t now = esp_timer_get_time();
+        stretchAwakeUs += now - wokeAt;
+        stats.idleAwakeUs += now - wokeAt;
+        stats.modelCurrentUa = estimateCurrentUa(stretchSleptUs, stretchAwakeUs, waitingUa());
+
+        uint64_t totalUs = now - idleSince;
+        unsigned long seconds = totalUs / 1000000;
+        unsigned waitingPct = totalUs ? stretchSleptUs * 100 / totalUs : 0;
+        unsigned long awakeUa = estimateCurrentUa(0, totalUs, CPU_ACTIVE_UA);
+        if (lightSleepActive)
+        {
+            logDeferred<LOG_IDLE_LEAVE>(seconds, waitingPct, (unsigned long)stats.modelCurrentUa, awakeUa);
+        }
+        else
+        {
+            logDeferred<LOG_IDLE_LEAVE_NO_SLEEP>(seconds, waitingPct, (unsigned long)stats.modelCurrentUa, awakeUa);
+        }
+    }
+
+    // Blocks the loop task until the frame is due or a button goes down;
+    // meanwhile the idle task lets the power manager light-sleep.
+    void wait(unsigned long ms)
+    {
+        Serial.flush(); // UART0 stops while the chip sleeps
+        waitingTask = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0); // a press from before this wait was already read
+        buttonWakePending = false; // a wake nobody pressed through (bounce) doesn't count
+        for (int i = 0; i < wakePinCount; i++)
+        {
+            gpio_intr_enable((gpio_num_t)wakePins[i]);
+        }
+
+        int64_t waitedAt = esp_timer_get_time();
+        stretchAwakeUs += waitedAt - wokeAt;
+        stats.idleAwakeUs += waitedAt - wokeAt;
+        bool pressed = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) > 0;
+        wokeAt = esp_timer_get_time(); // esp_timer keeps counting through light sleep
+
+        for (int i = 0; i < wakePinCount; i++)
+        {
+            gpio_intr_disable((gpio_num_t)wakePins[i]);
+        }
+        stretchSleptUs += wokeAt - waitedAt;
+        stats.sleptUs += wokeAt - waitedAt;
+        if (pressed)
+        {
+            stats.buttonWakes++;
+            buttonWakePending = true;
+        }
+        else
+        {
+            stats.timerWakes++;
+        }
+        stats.modelCurrentUa = estimateCurrentUa(stretchSleptUs, stretchAwakeUs, waitingUa());
+    }
+}
+
+void idleBegin(const int *buttonPins, int count)
+{
+    wakePinCount = count < MAX_WAKE_PINS ? count : MAX_WAKE_PINS;
+    for (int i = 0; i < wakePinCount; i++)
+    {
+        wakePins[i] = buttonPins[i];
+        attachInterrupt(wakePins[i], onButtonLow, ONLOW);
+        gpio_intr_disable((gpio_num_t)wakePins[i]);
+        gpio_wakeup_enable((gpio_num_t)wakePins[i], GPIO_INTR_LOW_LEVEL); // also wakes the chip from light sleep
+    }
+    esp_sleep_enable_gpio_wakeup();
+    lastActivityAt = millis();
+
+    // Full speed, no sleep until idle.
+    esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "simon-awake", &awakeLock);
+    esp_pm_lock_acquire(awakeLock);
+    esp_pm_config_esp32_t config = {};
+    config.max_freq_mhz = getCpuFrequencyMhz();
+    config.min_freq_mhz = PM_MIN_FREQ_MHZ;
+    config.light_sleep_enable = true;
+    esp_err_t err = esp_pm_configure(&config);
+    lightSleepActive = clockScalingActive = err == ESP_OK;
+    if (!lightSleepActive)
+    {
+        // No tickless idle in this build: frequency scaling only, if that.
+        config.light_sleep_enable = false;
+        esp_err_t scalingErr = esp_pm_configure(&config);
+        clockScalingActive = scalingErr == ESP_OK;
+        logDeferred<LOG_IDLE_NO_LIGHT_SLEEP>((int)err, (int)scalingErr);
+    }
+    stats.powerMode = lightSleepActive     ? IDLE_POWER_LIGHT_SLEEP
+                      : clockScalingActive ? IDLE_POWER_CLOCK_SCALING
+                                           : IDLE_POWER_AWAKE;
+}
+
+void idleActivity()
+{
+    lastActivityAt = millis();
+    if (idle)
+    {
+        leaveIdle();
+    }
+}
+
+void idleWait(unsigned long frameDueMs)
+{
+    unsigned long now = millis();
+    if (!idle)
+    {
+        if (IDLE_AFTER_MS == 0 || now - lastActivityAt < IDLE_AFTER_MS)
+        {
+            return;
+        }
+        enterIdle();
+    }
+
+    long waitMs = (long)(frameDueMs - now);
+    if (waitMs < (long)MIN_NAP_MS || anyButtonDown())
+    {
+        return; // a low button would end the wait at once
+    }
+    wait(waitMs);
+}
+
+void idleButtonSeen()
+{
+    if (buttonWakePending)
+    {
+        buttonWakePending = false;
+        uint32_t latencyUs = esp_timer_get_time() - buttonWokeAt;
+        stats.lastWakeLatencyUs = latencyUs;
+        if (latencyUs > stats.maxWakeLatencyUs)
+        {
+            stats.maxWakeLatencyUs = latencyUs;
+        }
+        if (latencyUs > IDLE_WAKE_BUDGET_US)
+        {
+            logDeferred<LOG_IDLE_WAKE_SLOW>((unsigned long)latencyUs);
+        }
+    }
+    idleActivity();
+}
+
+const IdleStats &idleStats()
+{
+    return stats;
+}
@@ -4,9 +4,32 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <vector>
 #include <WebServer.h>
 #include <stdint.h>
+#include "telemetry.h"
+#include "wifi_link.h"
+#include "wire_format.h"
+#include "request_fields.h"
+#include "session_queue.h"
+#include "packed_sequence.h"
+#include "pcg32.h"
+#include "replay.h"
+#include "difficulty.h"
+#include "game_modes.h"
+#include "game_core.h"
+#include "game_flow.h"
+#include "idle_power.h"
+#include "settings.h"
+#include "boot.h"
+#include "dfplayer.h"
+#include "fixed_string.h"
+#include "request_arena.h"
+#include "memory_telemetry.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "deferred_log.h"
+#include "trace.h"
+#include "web_assets.h" // generated from web/index.html by scripts/embed_web.py
 
 // ✅ Custom I2C Pins for LCD
 #define LCD_SDA 13
@@ -26,17 +49,24 @@
 #define LED_4 32 // Red (No)
 #define LED_5 26 // Yellow (Yes)
 
-// DFPlayer Mini Commands
-#define Start_Byte 0x7E
-#define Version_Byte 0xFF
-#define Command_Length 0x06
-#define End_Byte 0xEF
-#define Acknowledge 0x00
+// ✅ Longest sequence a marathon game can reach (4 KB of packed steps)
+#define MARATHON_MAX_STEPS 10000
 
 // ✅ Wi-Fi and Backend Configuration
 const char *targetSSID = "Daniel’s iPhone";                  // Update with your SSID
 const char *password = "12345678";                           // Update with your password
 const char *serverUrl = "http://172.20.10.11:8000/esp-data"; // FastAPI endpoint
+const char *submitScoreUrl = "http://172.20.10.11:8000/submit-score";
+const uint16_t backendConnectTimeoutMs = 2000; // Don't let a busy backend hold the cabinet
+const uint16_t backendResponseTimeoutMs = 3000;
+const bool preferMsgPack = true;                             // Try MessagePack first, fall back to JSON
+
+// ✅ Every wait outside the idle screens ends on its own, whatever the buttons or web app do
+//    (stuck buttons and abandoned games are bounded in game_flow.h, with the in-game timings)
+const unsigned long PROMPT_TIMEOUT_MS = 30000;      // Yes/No and menu prompts fall back to their default
+const unsigned long VOLUME_WAIT_TIMEOUT_MS = 60000; // web volume never came: keep the current one
+const unsigned long LOGIN_WAIT_TIMEOUT_MS = 120000; // web login never came: play offline
+const unsigned long PLAYER_IDLE_TIMEOUT_MS = 180000; // logged-in player left the start screen alone: log out
 
 // ✅ Web Server (ESP32 listens for login data)
 WebServer server(8000);
@@ -46,14 +76,37 @@ LiquidCrystal_I2C lcd(0x27, 16, 2);
 
 // ✅ Game Variables
 int selectedFolder = 0;
-std::vector<int> sequence;
-int playerIndex = 0;
+GameModeId gameMode = MODE_CLASSIC;
+#ifdef SIMON_SEEDED_SEQUENCE
+typedef SeededSequence SequenceStorage; // Steps regenerated from a seed, nothing stored
+#else
+typedef PackedSequence<MARATHON_MAX_STEPS> SequenceStorage; // 3 bits per step in a fixed array
+#endif
+SequenceStorage sequence;
+DifficultyEngine difficulty;
+Pcg32 rng;             // Seeded per game so any game can be regenerated
+uint32_t gameSeed = 0; // Recorded with the score
 int score = 0;
-int delayBetweenSteps = 800;
-String userID = ""; // Stores user ID after successful login
-String username = "";
-bool isLoggedIn = false;
 bool volumeReceived = false;
+unsigned long handoverStartedAt = 0; // Set when a queued player takes over, for turnaround timing
+unsigned long lastTurnaroundMs = 0;
+unsigned long playerIdleSince = 0; // Last game over or greeting of the current player
+bool playerLoggedOut = false;      // Set by /esp-logout for the current player; the start screen moves on
+WireFormat backendFormat = preferMsgPack ? WIRE_MSGPACK : WIRE_JSON; // Drops to JSON if the backend refuses
+char deviceID[13] = "";                                              // Wi-Fi MAC, identifies this cabinet
+// Longest score upload submitScore() can produce, for its buffer size
+const char SCORE_BODY_WIDEST[] = "{\"user_id\":-2147483648,\"score\":-2147483648,\"seed\":4294967295,"
+                                 "\"mode\":9,\"gen\":9,\"device_id\":\"FFFFFFFFFFFF\"}";
+static_assert(MODE_COUNT <= 10 && SEQUENCE_GEN_SEED_HASH <= 9, "SCORE_BODY_WIDEST has one digit for mode and gen");
+// Longest /queue reply: the active player and a full queue, each with a
+// SESSION_NAME_LEN name
+#define QUEUE_ENTRY_WIDEST "{\"user_id\":-2147483648,\"username\":\"NNNNNNNNNNNNNNNNNNNNNNNN\"}"
+const char QUEUE_REPLY_WIDEST[] =
+    "{\"active\":" QUEUE_ENTRY_WIDEST ",\"waiting\":[" QUEUE_ENTRY_WIDEST "," QUEUE_ENTRY_WIDEST
+    "," QUEUE_ENTRY_WIDEST "," QUEUE_ENTRY_WIDEST "," QUEUE_ENTRY_WIDEST "," QUEUE_ENTRY_WIDEST
+    "," QUEUE_ENTRY_WIDEST "," QUEUE_ENTRY_WIDEST "],\"last_turnaround_ms\":4294967295}";
+#undef QUEUE_ENTRY_WIDEST
+static_assert(SESSION_CAPACITY == 8, "QUEUE_REPLY_WIDEST lists eight queued players");
 
 // ✅ Define Button & LED Arrays
 const int buttons[] = {BTN_1, BTN_2, BTN_3, BTN_4, BTN_5};
@@ -62,28 +115,170 @@ const int leds[] = {LED_1, LED_2, LED_3, LED_4, LED_5};
 void execute_CMD(uint8_t CMD, uint8_t Par1, uint8_t Par2);
 void playInFolder(int fold, int track);
 void updateLCD(const char *line1, const char *line2);
+void showScore(const char *line2);
 void chooseSound();
 void startGame();
-void simonTurn();
-void playerTurn();
+void chooseMode();
+template <class Mode>
+void playGame();
 void gameOver();
 bool checkButtonPress(int &pressedButton);
-void ledCycleLoop();
+bool askYesNo();
+void attractFrame(int frame);
 void waitForStart();
 void askForLogin();
+void replyMessage(int code, const char *key, const char *text);
 void handleLoginRequest();
+void handleQueueRequest();
+void handleDifficultyRequest();
+void changePlayer(Session *next);
+void greetPlayer(Session *player);
+void handleLogoutRequest();
+void handleRoot();
 void submitScore(int score);
 void checkPing();
+void onWifiConnected();
+void serviceBackground();
+void serviceNetwork();
+
+// ✅ The cabinet side of game_flow.h: pins, DFPlayer, LCD, background services and instrumentation
+struct CabinetBoard
+{
+    class Scope
+    {
+    public:
+        Scope(FlowPhase phase, uint32_t arg) : profile(PROFILES[phase]), trace(TRACES[phase], arg) {}
+
+    private:
+        static constexpr ProfileId PROFILES[] = {PROFILE_SIMON_TURN, PROFILE_PLAYER_TURN, PROFILE_PLAYER_PRESS};
+        static constexpr TraceName TRACES[] = {TRACE_SIMON_TURN, TRACE_PLAYER_TURN, TRACE_PLAYER_PRESS};
+        ProfileScope profile;
+        TraceScope trace;
+    };
+
+    unsigned long millis() { return ::millis(); }
+    void delay(unsigned long ms) { ::delay(ms); }
+
+    bool buttonDown(int &button)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            if (digitalRead(buttons[i]) == LOW)
+            {
+                button = i;
+                metricsButtonPress(i);
+                idleButtonSeen();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool buttonHeld(int button) { return digitalRead(buttons[button]) == LOW; }
+    void led(int button, bool on) { digitalWrite(leds[button], on ? HIGH : LOW); }
+    void sound(int button) { playInFolder(selectedFolder, button + 1); }
+    void showScore(const char *line2) { ::showScore(line2); }
+    void lcd(const char *line1, const char *line2) { updateLCD(line1, line2); }
+    void background() { serviceBackground(); }
+
+    template <class Core>
+    void onRoundStart(const Core &core, int added)
+    {
+        for (size_t i = core.length() - added; i < core.length(); i++)
+        {
+            replayStep(core.sequence()[i]);
+        }
+        replayFlush(); // ✅ Flash write happens now, while no input is expected
+        memorySample(MEMORY_ROUND_START);
+        telemetryEmit(TELEMETRY_ROUND_START, core.round(), core.length());
+        logDeferred<LOG_ROUND_START>(core.length(), core.tempo().stepMs);
+        traceInstant(TRACE_ROUND_START, core.length());
+    }
+
+    void onStep(size_t index, uint8_t move)
+    {
+        telemetryEmit(TELEMETRY_SIMON_STEP, index, move);
+        telemetryPoll();
+    }
+
+    void onPress(int button, unsigned long reactionMs, bool correct)
+    {
+        replayPress(button);
+        telemetryEmit(TELEMETRY_PRESS, button, reactionMs, correct);
+        logDeferred<LOG_PRESS>(button, reactionMs, correct);
+    }
+
+    void onRoundCleared(int score)
+    {
+        telemetryEmit(TELEMETRY_SCORE, score);
+        telemetryPoll();
+        logDeferred<LOG_ROUND_CLEARED>(score);
+    }
+
+    void onGameEnd(GameEnd why)
+    {
+        switch (why)
+        {
+        case GAME_END_TIME_UP:
+            logDeferred<LOG_TIMES_UP>();
+            break;
+        case GAME_END_ABANDONED:
+            logDeferred<LOG_ABANDONED>();
+            break;
+        case GAME_END_MARATHON:
+            logDeferred<LOG_MARATHON_COMPLETE>();
+            break;
+        default:
+            break;
+        }
+    }
+};
+CabinetBoard cabinet;
+
+// ✅ Non-blocking housekeeping that is safe to run in the middle of a game
+void serviceBackground()
+{
+    wifiWatch(); // ✅ Reconnects and the ping that follows wait for serviceNetwork()
+    {
+        ProfileScope profile(PROFILE_TELEMETRY_POLL);
+        telemetryPoll();
+    }
+    memoryPoll();
+    profilerPoll();
+}
+
+// ✅ Same as above plus web requests, for menus and other wait loops
+void serviceNetwork()
+{
+    bootPoll(); // ✅ A boot step that outwaited the boot timeout (routes on a slow Wi-Fi start) runs here
+    if (wifiPoll())
+    {
+        onWifiConnected();
+    }
+    serviceBackground();
+    {
+        ProfileScope profile(PROFILE_HANDLE_CLIENT);
+        server.handleClient();
+    }
+    if (metricsRequestDone())
+    {
+        idleActivity(); // ✅ A web request keeps the cabinet awake like a press does
+    }
+    settingsPoll(); // ✅ Never mid-round: the game only calls serviceBackground()
+    wifiFlushCache();
+}
 
 void setVolume(int volume)
 {
-    execute_CMD(0x06, 0, volume);
+    execute_CMD(DFPLAYER_SET_VOLUME, 0, volume);
     delay(200);
 }
 
 // ✅ Function to update LCD screen
 void updateLCD(const char *line1, const char *line2)
 {
+    ProfileScope profile(PROFILE_UPDATE_LCD);
+    TraceScope trace(TRACE_UPDATE_LCD);
     lcd.clear();
     lcd.setCursor(0, 0);
     lcd.print(line1);
@@ -91,40 +286,40 @@ void updateLCD(const char *line1, const char *line2)
     lcd.print(line2);
 }
 
+// ✅ "Score: N" on the first line, built without touching the heap
+void showScore(const char *line2)
+{
+    FixedString<16> line1("Score: ");
+    line1 += score;
+    updateLCD(line1.c_str(), line2);
+}
+
 void execute_CMD(uint8_t CMD, uint8_t Par1, uint8_t Par2)
 {
-    int16_t checksum = -(Version_Byte + Command_Length + CMD + Acknowledge + Par1 + Par2);
-    uint8_t Command_line[10] = {Start_Byte, Version_Byte, Command_Length, CMD, Acknowledge,
-                                Par1, Par2, highByte(checksum), lowByte(checksum), End_Byte};
-    for (uint8_t k = 0; k < 10; k++)
-    {
-        Serial2.write(Command_line[k]);
-    }
+    ProfileScope profile(PROFILE_EXECUTE_CMD);
+    TraceScope trace(TRACE_EXECUTE_CMD, CMD);
+    uint8_t Command_line[DFPLAYER_FRAME_SIZE];
+    dfplayerFrame(Command_line, CMD, Par1, Par2);
+    Serial2.write(Command_line, sizeof(Command_line)); // ✅ One UART write per frame
+    metricsDfplayerCommand();
 }
 
+// ✅ Starts the track and returns; callers hold the LED for as long as the tempo says
 void playInFolder(int fold, int track)
 {
-    int upper = fold * 16 + track / 256;
-    int lower = track % 256;
-    execute_CMD(0x14, upper, lower);
-    delay(500);
+    ProfileScope profile(PROFILE_EXECUTE_CMD);
+    TraceScope trace(TRACE_PLAY_IN_FOLDER, track);
+    uint8_t frame[DFPLAYER_FRAME_SIZE];
+    dfplayerPlayInFolder(frame, fold, track);
+    Serial2.write(frame, sizeof(frame));
+    metricsDfplayerCommand();
 }
 
 // ✅ Function to check button press (Debounce)
 bool checkButtonPress(int &pressedButton)
 {
-    for (int i = 0; i < 5; i++)
-    {
-        if (digitalRead(buttons[i]) == LOW)
-        {
-            delay(150);
-            while (digitalRead(buttons[i]) == LOW)
-                ;
-            pressedButton = i;
-            return true;
-        }
-    }
-    return false;
+    unsigned long downAt;
+    return readPress(cabinet, pressedButton, downAt);
 }
 
 void chooseSound()
@@ -148,10 +343,26 @@ void chooseSound()
     Serial.println("🟣 Purple -> Harp");
     Serial.println("🟡 Yellow -> Violin");
 
+    unsigned long promptedAt = millis();
     while (true)
     {
         int pressedButton;
         delay(200);
+        if (millis() - promptedAt > PROMPT_TIMEOUT_MS)
+        {
+            // ✅ Nobody chose: keep the current sound (Classic if there is none yet) and mode
+            for (int i = 0; i < 5; i++)
+            {
+                digitalWrite(leds[i], LOW);
+            }
+            if (selectedFolder == 0)
+            {
+                selectedFolder = 1;
+            }
+            Serial.printf("⏰ No sound chosen, using folder %d\n", selectedFolder);
+            settingsSetFolder(selectedFolder);
+            return;
+        }
         if (checkButtonPress(pressedButton))
         {
             // ✅ Map buttons to specific folders
@@ -178,7 +389,7 @@ void chooseSound()
             }
 
             // ✅ Define folder names
-            String folderName;
+            const char *folderName = "Classic";
             switch (selectedFolder)
             {
             case 1:
@@ -214,6 +425,12 @@ void chooseSound()
             lcd.setCursor(0, 1);
             lcd.print(folderName);
 
+            if (Session *player = sessionActive())
+            {
+                player->folder = selectedFolder; // ✅ Remember for this player's next game
+            }
+            settingsSetFolder(selectedFolder); // ✅ And for the cabinet's next boot
+
             Serial.print("✅ Sound Folder ");
             Serial.print(selectedFolder);
             Serial.print(" (");
@@ -225,105 +442,182 @@ void chooseSound()
             // ✅ Turn off the selected LED
             digitalWrite(leds[pressedButton], LOW);
 
+            chooseMode(); // ✅ Mode is picked on the same menu pass
             return; // Exit function after selection
         }
     }
 }
 
-// ✅ Function to start the game (MISSING DEFINITION FIXED)
-void startGame()
+// ✅ Pick a game mode right after the sound (Yellow keeps the current one)
+void chooseMode()
 {
-    sequence.clear();
-    score = 0;
-    playerIndex = 0;
-    delayBetweenSteps = 800;
-    updateLCD("Game Started!", "Watch Simon");
-    delay(1000);
-    simonTurn();
-}
+    updateLCD("Choose Mode:", "Yellow: keep");
+    for (int i = 0; i < 5; i++)
+    {
+        digitalWrite(leds[i], HIGH);
+    }
 
-void waitForStart()
-{
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("Press a button");
-    lcd.setCursor(0, 1);
-    lcd.print("to start game!");
+    Serial.println("🕹️ Choose a game mode by pressing a button:");
+    Serial.println("🟣 Purple -> Classic");
+    Serial.println("🟢 Green  -> Reverse");
+    Serial.println("⚪ White  -> Time Attack");
+    Serial.println("🔴 Red    -> Double Step");
+    Serial.printf("🟡 Yellow -> keep %s\n", GAME_MODE_NAMES[gameMode]);
 
-    Serial.println("🎮 Waiting for user to start the game...");
+    int pressedButton = MODE_COUNT; // ✅ Timing out is the same as Yellow: keep the mode
+    unsigned long promptedAt = millis();
+    while (millis() - promptedAt < PROMPT_TIMEOUT_MS && !checkButtonPress(pressedButton))
+    {
+        delay(20);
+    }
+    if (pressedButton < MODE_COUNT)
+    {
+        gameMode = (GameModeId)pressedButton;
+        settingsSetMode(gameMode);
+    }
 
-    while (true)
+    for (int i = 0; i < 5; i++)
     {
-        ledCycleLoop();
-        int pressedButton;
-        if (checkButtonPress(pressedButton))
-        {
-            if (selectedFolder == 0)
-            {
-                Serial.println("⚠️ No folder selected! Asking again...");
-                chooseSound();
-            }
-            startGame();
-            return;
-        }
+        digitalWrite(leds[i], LOW);
     }
+    updateLCD("Mode Selected:", GAME_MODE_NAMES[gameMode]);
+    Serial.printf("✅ Mode %s selected!\n", GAME_MODE_NAMES[gameMode]);
+    delay(1500);
 }
 
-void simonTurn()
+// ✅ Function to start the game (MISSING DEFINITION FIXED)
+void startGame()
 {
-    sequence.push_back(random(0, 5));
-    updateLCD(("Score: " + String(score)).c_str(), "Simon's Turn");
-
-    for (int move : sequence)
+    if (handoverStartedAt != 0)
     {
-        digitalWrite(leds[move], HIGH);
-        playInFolder(selectedFolder, move + 1);
-        delay(delayBetweenSteps);
-        digitalWrite(leds[move], LOW);
-        delay(300);
+        lastTurnaroundMs = millis() - handoverStartedAt;
+        handoverStartedAt = 0;
+        Serial.printf("⏱️ Player turnaround: %lu ms\n", lastTurnaroundMs);
     }
 
-    delayBetweenSteps = max(200, delayBetweenSteps - (score / 10));
-    updateLCD(("Score: " + String(score)).c_str(), "Your Turn");
-    playerIndex = 0;
-    playerTurn();
+    // ✅ Fresh hardware-entropy seed per game, logged and uploaded with the score
+    gameSeed = esp_random();
+    Serial.printf("🎲 Game seed: %lu, mode: %s\n", (unsigned long)gameSeed, GAME_MODE_NAMES[gameMode]);
+    replayStart(gameSeed, selectedFolder, gameMode);
+    score = 0;
+    updateLCD("Game Started!", "Watch Simon");
+    delay(1000);
+
+    // ✅ The only runtime branch on the mode: each case is its own specialised loop
+    switch (gameMode)
+    {
+    case MODE_REVERSE:
+        playGame<ReverseMode>();
+        break;
+    case MODE_TIME_ATTACK:
+        playGame<TimeAttackMode>();
+        break;
+    case MODE_DOUBLE_STEP:
+        playGame<DoubleStepMode>();
+        break;
+    default:
+        playGame<ClassicMode>();
+        break;
+    }
 }
 
-void playerTurn()
+// ✅ Idle screen and main game loop: start, play, game over, repeat
+void waitForStart()
 {
-    int pressedButton;
-    while (playerIndex < sequence.size())
+    while (true)
     {
-        if (checkButtonPress(pressedButton))
+        lcd.clear();
+        lcd.setCursor(0, 0);
+        lcd.print("Press a button");
+        lcd.setCursor(0, 1);
+        lcd.print("to start game!");
+
+        Serial.println("🎮 Waiting for user to start the game...");
+        settingsMarkPlayable();
+
+        // ✅ One attract frame at a time; after IDLE_AFTER_MS without activity
+        //    idleWait() blocks between frames so the chip can light-sleep; any button ends it
+        idleActivity();
+        int frame = 0;
+        unsigned long frameDueAt = millis();
+        while (true)
         {
-            if (pressedButton == sequence[playerIndex])
+            // ✅ Buttons first, so a press that woke the chip is seen before anything else runs
+            int pressedButton;
+            if (checkButtonPress(pressedButton))
             {
-                digitalWrite(leds[pressedButton], HIGH);
-                playInFolder(selectedFolder, pressedButton + 1);
-                delay(300);
-                digitalWrite(leds[pressedButton], LOW);
-                playerIndex++;
+                break;
+            }
+
+            serviceNetwork();
+
+            // ✅ Players change here, between games: a logout from the web, a logged-in
+            //    player idle too long, or a queued login while nobody is playing
+            bool timedOut = sessionActive() && millis() - playerIdleSince > PLAYER_IDLE_TIMEOUT_MS;
+            if (timedOut)
+            {
+                Serial.printf("⌛ %s idle for %lu s, logged out\n", sessionActive()->username,
+                              PLAYER_IDLE_TIMEOUT_MS / 1000);
+                sessionLogout(sessionActive()->userId);
             }
-            else
+            if (timedOut || playerLoggedOut || (!sessionActive() && sessionWaiting() > 0))
             {
-                gameOver();
-                return;
+                playerLoggedOut = false;
+                idleActivity();
+                changePlayer(sessionAdvance());
+                updateLCD("Press a button", "to start game!");
             }
+
+            if ((long)(millis() - frameDueAt) >= 0)
+            {
+                attractFrame(frame++);
+                frameDueAt = millis() + ATTRACT_FRAME_MS;
+            }
+            idleWait(frameDueAt);
         }
+        for (int i = 0; i < 5; i++)
+        {
+            digitalWrite(leds[i], LOW);
+        }
+
+        if (selectedFolder == 0)
+        {
+            Serial.println("⚠️ No folder selected! Asking again...");
+            chooseSound();
+        }
+        startGame();
+        gameOver();
     }
+}
 
-    score += 10;
-    Serial.print(F("Correct! Score: "));
-    Serial.println(score);
-    delay(1000);
-    simonTurn();
+// ✅ One whole game; the turns themselves are in game_flow.h
+template <class Mode>
+void playGame()
+{
+    GameCore<Mode, SequenceStorage> core(sequence, rng, difficulty, MARATHON_MAX_STEPS);
+    core.start(gameSeed);
+
+    uint32_t rounds = playRounds(cabinet, core, score);
+    metricsGamePlayed(rounds, score);
 }
 
 void gameOver()
 {
-    Serial.println(F("❌ Game Over!"));
-    Serial.print(F("🏆 Final Score: "));
-    Serial.println(score);
+    logDeferred<LOG_GAME_OVER>();
+    logDeferred<LOG_FINAL_SCORE>(score);
+    telemetryEmit(TELEMETRY_GAME_OVER, score);
+    traceInstant(TRACE_GAME_OVER, score);
+    telemetryPoll();
+    replayFinish(score);
+
+    char difficultyJson[DIFFICULTY_JSON_MAX];
+    difficulty.toJson(difficultyJson, sizeof(difficultyJson));
+    Serial.print(F("🎚️ Difficulty: "));
+    Serial.println(difficultyJson);
+
+    memorySample(MEMORY_GAME_OVER); // ✅ Free heap, largest block and stack high-water marks
+    memoryPrint(Serial);
+    profilerPrint(Serial); // ✅ Prints nothing unless built with -DSIMON_PROFILER
 
     for (int i = 0; i < 3; i++) {
         lcd.clear();
@@ -343,44 +637,42 @@ void gameOver()
 
     // ✅ Send score to FastAPI
     submitScore(score);
-    if (isLoggedIn) {
+
+    // ✅ Someone is queued: this player's turn is over, hand over straight away, no prompts
+    if (sessionWaiting() > 0)
+    {
+        handoverStartedAt = millis();
+        changePlayer(sessionAdvance());
+        return;
+    }
+
+    if (sessionActive()) {
         lcd.clear();
         lcd.setCursor(0, 0);
         lcd.print("Change Volume?");
         lcd.setCursor(0, 1);
         lcd.print("Red:No Ylw:Yes");
  
-        digitalWrite(LED_5, HIGH); // Yellow
-        digitalWrite(LED_4, HIGH); // Red
- 
         Serial.println("🔉 Do you want to change the volume?");
         Serial.println("🔴 Red = NO, 🟡 Yellow = YES");
  
-        while (true) {
-            if (digitalRead(BTN_5) == LOW) {
-                Serial.println("🟡 Waiting for volume from web...");
-                digitalWrite(LED_5, LOW);
-                digitalWrite(LED_4, LOW);
-                lcd.clear();
-                lcd.setCursor(0, 0);
-                lcd.print("Waiting Volume");
-                volumeReceived = false;  // ✅ Reset before waiting
-                
-                while (!volumeReceived) {
-                    server.handleClient();
-                    delay(100);
-                }
- 
-                break;
+        if (askYesNo()) {
+            Serial.println("🟡 Waiting for volume from web...");
+            lcd.clear();
+            lcd.setCursor(0, 0);
+            lcd.print("Waiting Volume");
+            volumeReceived = false;  // ✅ Reset before waiting
+
+            unsigned long waitStartedAt = millis();
+            while (!volumeReceived && millis() - waitStartedAt < VOLUME_WAIT_TIMEOUT_MS) {
+                serviceNetwork();
+                delay(100);
             }
- 
-            if (digitalRead(BTN_4) == LOW) {
-                Serial.println("🔴 Skipping volume. Using previous/default.");
-                digitalWrite(LED_5, LOW);
-                digitalWrite(LED_4, LOW);
-                break;
+            if (!volumeReceived) {
+                Serial.println("⏰ No volume from web. Using previous/default.");
             }
-            delay(100);
+        } else {
+            Serial.println("🔴 Skipping volume. Using previous/default.");
         }
     }
 
@@ -396,49 +688,73 @@ void gameOver()
     Serial.println("🟡 Press Yellow for YES");
     Serial.println("🔴 Press Red for NO");
 
+    if (askYesNo())
+    { // Yellow button pressed (Change Sound)
+        Serial.println("🎵 User wants to change the sound.");
+        delay(1000);
+        chooseSound();
+    }
+    else
+    { // Red button pressed or nobody answered (Continue Playing)
+        Serial.println("▶️ User chose to continue playing.");
+    }
+
+    // ✅ The player stays logged in for the next game, with their volume and sound,
+    //    until they log out or leave the start screen idle
+    playerIdleSince = millis();
+
+    // ✅ Back to the start screen (waitForStart loops around)
+    delay(2000);
+}
+
+// ✅ Yellow = Yes, Red = No; keeps the web server running and answers No after PROMPT_TIMEOUT_MS
+bool askYesNo()
+{
     digitalWrite(LED_5, HIGH); // Yellow LED ON (Yes)
     digitalWrite(LED_4, HIGH); // Red LED ON (No)
 
-    while (true)
+    bool yes = false;
+    unsigned long promptedAt = millis();
+    while (millis() - promptedAt < PROMPT_TIMEOUT_MS)
     {
+        serviceNetwork();
         if (digitalRead(BTN_5) == LOW)
-        { // Yellow button pressed (Change Sound)
-            Serial.println("🎵 User wants to change the sound.");
-            digitalWrite(LED_5, LOW);
-            digitalWrite(LED_4, LOW);
-            delay(1000);
-            chooseSound();
+        {
+            yes = true;
             break;
         }
-
         if (digitalRead(BTN_4) == LOW)
-        { // Red button pressed (Continue Playing)
-            Serial.println("▶️ User chose to continue playing.");
-            digitalWrite(LED_5, LOW);
-            digitalWrite(LED_4, LOW);
+        {
             break;
         }
-        delay(200);
+        delay(100);
     }
 
-    // ✅ Restart the game process
-    delay(2000);
-    waitForStart();
+    digitalWrite(LED_5, LOW);
+    digitalWrite(LED_4, LOW);
+    return yes;
 }
 
-void ledCycleLoop()
+// ✅ Attract animation: one LED at a time, left to right, ATTRACT_FRAME_MS each
+void attractFrame(int frame)
 {
-    for (int i = 0; i < 5; i++)
-    {
-        digitalWrite(leds[i], HIGH);
-        delay(150);
-        digitalWrite(leds[i], LOW);
-    }
+    digitalWrite(leds[(frame + 4) % 5], LOW);
+    digitalWrite(leds[frame % 5], HIGH);
 }
 
 // ✅ Ask User if They Want to Log In
 void askForLogin()
 {
+    // ✅ Answered on an earlier boot and a sound is on record: straight to the start screen.
+    //    Web logins are still picked up there, from the queue.
+    if (settings().login != LOGIN_ASK && selectedFolder != 0)
+    {
+        Serial.printf("⚡ Saved settings: %s, folder %d, skipping the boot prompts\n",
+                      settings().login == LOGIN_WEB ? "web login" : "offline", selectedFolder);
+        waitForStart();
+        return;
+    }
+
     lcd.clear();
     lcd.setCursor(0, 0);
     lcd.print("Login via Web?");
@@ -450,42 +766,55 @@ void askForLogin()
 
     while (true)
     {
+        serviceNetwork();
+        bool playOffline = false;
         if (digitalRead(BTN_5) == LOW)
         { // Yellow button pressed (Log in)
             Serial.println("✅ Waiting for Web Login...");
+            settingsSetLogin(LOGIN_WEB);
             digitalWrite(LED_5, LOW);
             digitalWrite(LED_4, LOW);
             lcd.clear();
             lcd.print("Waiting for login...");
+            lcd.setCursor(0, 1);
+            lcd.print("Red: Offline");
 
-            // ✅ Wait until the user logs in
-            while (!isLoggedIn)
+            // ✅ Wait until the user logs in (Wi-Fi may still be coming up)
+            unsigned long waitStartedAt = millis();
+            while (sessionWaiting() == 0 && millis() - waitStartedAt < LOGIN_WAIT_TIMEOUT_MS)
             {
-                server.handleClient();
+                serviceNetwork();
+                if (digitalRead(BTN_4) == LOW)
+                {
+                    break;
+                }
                 delay(100);
             }
-
-            // ✅ Once logged in, print username and ask for sound selection
-            lcd.clear();
-            lcd.setCursor(0, 0);
-            lcd.print("Hello, ");
-            lcd.print(username);
-            lcd.setCursor(0, 1);
-            lcd.print("ID: ");
-            lcd.print(userID);
-
-        Serial.println("✅ User Logged In: " + username + " (ID: " + userID + ")");
-
-        // ✅ Ask user to choose a sound after login
-        chooseSound();
-        delay(1000);
-        waitForStart(); // ensures LED loop before starting
-        return;
+            playOffline = sessionWaiting() == 0; // Red pressed, or the login never came
+            if (!playOffline)
+            {
+                // ✅ Once logged in, greet the player and ask for sound selection
+                Session *player = sessionAdvance();
+                changePlayer(player);
+
+                // ✅ Ask user to choose a sound after login, unless they already picked one
+                if (player->folder == 0)
+                {
+                    chooseSound();
+                }
+                delay(1000);
+                waitForStart(); // ensures LED loop before starting
+                return;
+            }
         }
 
-        if (digitalRead(BTN_4) == LOW)
-        { // Red button pressed (Offline Mode)
+        if (playOffline || digitalRead(BTN_4) == LOW)
+        { // Red button pressed or login timed out (Offline Mode)
             Serial.println("❌ User chose NOT to log in.");
+            if (!playOffline)
+            {
+                settingsSetLogin(LOGIN_OFFLINE); // ✅ Red on the prompt itself, not a login that never came
+            }
             digitalWrite(LED_5, LOW);
             digitalWrite(LED_4, LOW);
             lcd.clear();
@@ -502,68 +831,189 @@ void askForLogin()
     }
 }
 
-// ✅ Handle Login Data from Web App
-void handleLoginRequest()
+// ✅ Serve the control page straight from flash (gzip, revalidated by ETag)
+void handleRoot()
 {
-    String body = server.arg("plain");
-    Serial.println("📩 Received Login Data: " + body);
+    unsigned long startedAt = micros();
+    server.sendHeader("ETag", INDEX_HTML_ETAG);
+    server.sendHeader("Cache-Control", "no-cache"); // always revalidate, usually a 304
 
-    JsonDocument doc;
-    deserializeJson(doc, body);
-    userID = doc["user_id"].as<String>();
-    username = doc["username"].as<String>();
-    isLoggedIn = true;
+    if (server.header("If-None-Match") == INDEX_HTML_ETAG)
+    {
+        server.send(304);
+        Serial.printf("🌐 GET / 304 (0 bytes) in %lu us\n", micros() - startedAt);
+        return;
+    }
 
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("Hello, ");
-    lcd.print(username);
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, "text/html", (const char *)INDEX_HTML_GZ, INDEX_HTML_GZ_LEN);
+    Serial.printf("🌐 GET / 200 (%u bytes gzip, %u raw) in %lu us\n",
+                  (unsigned)INDEX_HTML_GZ_LEN, (unsigned)INDEX_HTML_RAW_LEN, micros() - startedAt);
+}
 
-    Serial.println("✅ User Logged In: " + username + " (ID: " + userID + ")");
-    server.send(200, "text/plain", "Login Data Received");
+// ✅ Every change of player goes through here, so nobody inherits the last player's tempo;
+//    nullptr = guest, on the cabinet's own volume and sound
+void changePlayer(Session *next)
+{
+    difficulty.reset(); // ✅ New player starts from the classic tempo
+    playerIdleSince = millis();
+    if (next)
+    {
+        greetPlayer(next);
+        return;
+    }
+    Serial.println("👤 Nobody logged in: guest games");
+    setVolume(settings().volume);
+    if (settings().folder != 0)
+    {
+        selectedFolder = settings().folder;
+    }
+}
 
-    delay(2000);
-    // Insert volume control prompt before sound selection
+// ✅ Show a player's name and apply their preferences
+void greetPlayer(Session *player)
+{
     lcd.clear();
     lcd.setCursor(0, 0);
-    lcd.print("Custom Volume?");
+    lcd.print("Hello, ");
+    lcd.print(player->username);
     lcd.setCursor(0, 1);
-    lcd.print("Red:No Ylw:Yes");
-    digitalWrite(LED_5, HIGH);
-    digitalWrite(LED_4, HIGH);
+    lcd.print("ID: ");
+    lcd.print(player->userId);
 
-    Serial.println("🔊 Ask user to set volume via web?");
-    Serial.println("🟡 Yellow = YES, 🔴 Red = NO");
+    Serial.printf("✅ User Logged In: %s (ID: %ld), %d waiting\n",
+                  player->username, player->userId, sessionWaiting());
 
-    while (true) {
-        if (digitalRead(BTN_5) == LOW) {
-            Serial.println("🟡 Waiting for volume from web...");
-            digitalWrite(LED_5, LOW);
-            digitalWrite(LED_4, LOW);
-            lcd.clear();
-            lcd.setCursor(0, 0);
-            lcd.print("Waiting Volume");
+    if (player->volume >= 0)
+    {
+        setVolume(player->volume);
+    }
+    if (player->folder != 0)
+    {
+        selectedFolder = player->folder;
+    }
+    delay(1500);
+}
 
-            while (!volumeReceived) {
-                server.handleClient();
-                delay(100);
-            }
-            break;
-        }
-        if (digitalRead(BTN_4) == LOW) {
-            Serial.println("🔴 Skipping volume. Using default.");
-            setVolume(25);
-            digitalWrite(LED_5, LOW);
-            digitalWrite(LED_4, LOW);
-            break;
-        }
-        delay(100);
+// ✅ {"<key>": "<text>"} in the format the client accepts (JSON or MessagePack)
+void replyMessage(int code, const char *key, const char *text)
+{
+    RequestScope scope("reply");
+    JsonDocument reply(requestAllocator());
+    reply[key] = text;
+    wireRespond(server, code, reply);
+}
+
+// ✅ Handle Login Data from Web App (queues the player, never blocks)
+void handleLoginRequest()
+{
+    Serial.printf("📩 Received Login Data (%u bytes)\n", (unsigned)wireBodyLength());
+
+    RequestScope scope("esp-login");
+    JsonDocument doc(requestAllocator());
+    if (wireDecodeRequest(server, doc))
+    {
+        Serial.println("❌ Failed to parse login data");
+        replyMessage(400, "error", "Invalid body");
+        return;
     }
 
-    // ✅ Ask user to choose a sound before starting the game
-    chooseSound(); // This now ensures sound selection happens before game starts
-    delay(1000);
-    waitForStart();
+    LoginFields login;
+    FieldCheck check = checkLoginFields(doc, login);
+    if (check != FIELDS_OK)
+    {
+        replyMessage(400, "error", FIELD_CHECK_ERRORS[check]);
+        return;
+    }
+
+    int position = sessionEnqueue(login.userId, login.username, login.volume, login.folder);
+    if (position == 0)
+    {
+        Serial.println("❌ Player queue full, login rejected");
+        replyMessage(503, "error", "Queue full");
+        return;
+    }
+    if (position == SESSION_PLAYING)
+    {
+        Serial.printf("📋 %s is already playing, preferences updated\n", login.username);
+        replyMessage(200, "message", "Playing");
+        return;
+    }
+
+    Serial.printf("📋 %s queued at position %d\n", login.username, position);
+    JsonDocument reply(requestAllocator());
+    reply["message"] = "Queued";
+    reply["position"] = position;
+    wireRespond(server, 200, reply);
+}
+
+// ✅ Log a player out from the web app: {"user_id": 42}; the start screen moves on
+void handleLogoutRequest()
+{
+    RequestScope scope("esp-logout");
+    JsonDocument doc(requestAllocator());
+    if (wireDecodeRequest(server, doc) || !doc["user_id"].is<long>())
+    {
+        replyMessage(400, "error", "Invalid body");
+        return;
+    }
+    long userId = doc["user_id"].as<long>();
+    Session *player = sessionActive();
+    bool wasPlaying = player && player->userId == userId;
+    if (!sessionLogout(userId))
+    {
+        replyMessage(404, "error", "Not logged in");
+        return;
+    }
+    playerLoggedOut |= wasPlaying;
+    Serial.printf("👋 User %ld logged out%s\n", userId, wasPlaying ? "" : " of the queue");
+    replyMessage(200, "message", "Logged out");
+}
+
+// ✅ Current player and everyone waiting, for the web app
+void handleQueueRequest()
+{
+    RequestScope scope("queue");
+    JsonDocument doc(requestAllocator());
+    if (Session *player = sessionActive())
+    {
+        doc["active"]["user_id"] = player->userId;
+        doc["active"]["username"] = player->username;
+    }
+    JsonArray waiting = doc["waiting"].to<JsonArray>();
+    for (int i = 0; i < sessionWaiting(); i++)
+    {
+        const Session *queued = sessionPeek(i);
+        JsonObject entry = waiting.add<JsonObject>();
+        entry["user_id"] = queued->userId;
+        entry["username"] = queued->username;
+    }
+    doc["last_turnaround_ms"] = lastTurnaroundMs;
+
+    uint8_t reply[640];
+    static_assert(sizeof(QUEUE_REPLY_WIDEST) <= sizeof(reply), "queue reply does not fit");
+    wireRespond(server, 200, doc, reply, sizeof(reply));
+}
+
+// ✅ Difficulty engine state for tuning; ?target=0.85 changes the target success rate
+void handleDifficultyRequest()
+{
+    if (server.hasArg("target"))
+    {
+        difficulty.setTarget(server.arg("target").toFloat());
+        settingsSetDifficultyTarget(difficulty.state().targetSuccess); // ✅ Clamped value
+    }
+    char reply[DIFFICULTY_JSON_MAX];
+    difficulty.toJson(reply, sizeof(reply));
+    server.send(200, "application/json", reply);
+}
+
+// ✅ Runs once each time the background Wi-Fi link comes up
+void onWifiConnected()
+{
+    Serial.print("🌐 ESP32 IP Address: ");
+    Serial.println(WiFi.localIP());
+    checkPing();
 }
 
 // ✅ Check Backend Connection (Ping)
@@ -584,56 +1034,190 @@ void checkPing()
 
 void submitScore(int score)
 {
-    if (!isLoggedIn)
+    ProfileScope profile(PROFILE_SUBMIT_SCORE);
+    TraceScope trace(TRACE_SUBMIT_SCORE);
+    Session *player = sessionActive();
+    if (!player)
+    {
+        logDeferred<LOG_UPLOAD_NO_USER>();
+        return;
+    }
+    if (!wifiConnected())
+    {
+        logDeferred<LOG_UPLOAD_OFFLINE>();
+        metricsScoreUpload(METRICS_UPLOAD_SKIPPED);
+        return;
+    }
+
+    RequestScope scope("submit-score");
+    JsonDocument doc(requestAllocator());
+    doc["user_id"] = player->userId;
+    doc["score"] = score;
+    doc["seed"] = gameSeed;
+    doc["mode"] = (int)gameMode; // ✅ Seed, mode and generator regenerate the game
+    doc["gen"] = (int)sequenceGenerator(sequence);
+    doc["device_id"] = deviceID;
+
+    // ✅ Room for the widest JSON body: every number at its longest
+    uint8_t requestBody[128];
+    static_assert(sizeof(SCORE_BODY_WIDEST) <= sizeof(requestBody), "score upload body does not fit");
+    size_t length = wireEncode(doc, requestBody, sizeof(requestBody), backendFormat);
+    if (length == 0)
     {
-        Serial.println("❌ No user logged in. Skipping score upload.");
+        logDeferred<LOG_UPLOAD_TOO_LARGE>((unsigned)sizeof(requestBody));
+        metricsScoreUpload(METRICS_UPLOAD_FAILED);
         return;
     }
 
+    unsigned long startedAt = millis();
     HTTPClient http;
-    http.begin("http://172.20.10.11:8000/submit-score");
-    http.addHeader("Content-Type", "application/json");
+    http.setConnectTimeout(backendConnectTimeoutMs);
+    http.setTimeout(backendResponseTimeoutMs);
+    http.begin(submitScoreUrl);
+    http.addHeader("Accept", "application/msgpack, application/json");
+    http.addHeader("Content-Type", wireContentType(backendFormat));
+    traceEnter(TRACE_SCORE_POST);
+    int httpResponseCode = http.POST(requestBody, length);
+
+    // ✅ Backend doesn't understand MessagePack: remember and resend as JSON
+    if (backendFormat == WIRE_MSGPACK &&
+        (httpResponseCode == 415 || httpResponseCode == 422 || httpResponseCode == 400))
+    {
+        logDeferred<LOG_UPLOAD_JSON_FALLBACK>();
+        backendFormat = WIRE_JSON;
+        http.end();
+        length = wireEncode(doc, requestBody, sizeof(requestBody), backendFormat);
+        if (length > 0)
+        {
+            http.begin(submitScoreUrl);
+            http.addHeader("Accept", "application/msgpack, application/json");
+            http.addHeader("Content-Type", wireContentType(backendFormat));
+            httpResponseCode = http.POST(requestBody, length);
+        }
+    }
 
-    String requestBody = "{\"user_id\": " + userID + ", \"score\": " + String(score) + "}";
-    int httpResponseCode = http.POST(requestBody);
+    traceLeave(TRACE_SCORE_POST);
+    unsigned long latency = millis() - startedAt;
 
+    // ✅ Upload counts and the latency histogram are on /metrics
     if (httpResponseCode == 200)
     {
-        Serial.println("✅ Score uploaded successfully!");
+        metricsScoreUpload(METRICS_UPLOAD_SUCCEEDED, latency * 1000);
+        logDeferred<LOG_UPLOAD_OK>(latency);
     }
     else
     {
-        Serial.println("❌ Failed to upload score.");
+        uint32_t failed = metricsScoreUpload(METRICS_UPLOAD_FAILED, latency * 1000);
+        logDeferred<LOG_UPLOAD_FAILED>(httpResponseCode, latency, failed);
     }
     http.end();
 }
 
-// ✅ Setup Function (Game + FastAPI Integration)
-void setup()
+// ✅ Boot steps (boot.h): independent ones run at the same time, so the first
+//    screen, pins and DFPlayer don't wait for the Wi-Fi driver or the flash mount
+enum BootStepId
+{
+    STEP_SETTINGS,
+    STEP_LCD,
+    STEP_PINS,
+    STEP_DFPLAYER,
+    STEP_STORAGE,
+    STEP_WIFI,
+    STEP_ROUTES,
+    STEP_COUNT,
+};
+
+// ✅ Sound, volume, mode, difficulty and login answer from the last run (NVS)
+void bootSettings()
+{
+    settingsLoad();
+    selectedFolder = settings().folder;
+    if (settings().mode < MODE_COUNT)
+    {
+        gameMode = (GameModeId)settings().mode;
+    }
+    if (settings().difficultyTarget > 0)
+    {
+        difficulty.setTarget(settings().difficultyTarget);
+    }
+}
+
+// ✅ Initialize LCD: the first thing the player sees
+void bootLcd()
+{
+    Wire.begin(LCD_SDA, LCD_SCL);
+    lcd.begin(16, 2);
+    lcd.backlight();
+    lcd.clear();
+    updateLCD("Booting Up...", "");
+    bootMark(BOOT_MARK_FIRST_SCREEN);
+}
+
+// ✅ Set button & LED pins
+void bootPins()
+{
+    for (int i = 0; i < 5; i++)
+    {
+        pinMode(leds[i], OUTPUT);
+        pinMode(buttons[i], INPUT_PULLUP);
+    }
+    idleBegin(buttons, 5); // ✅ Any button wakes the cabinet from idle light sleep
+}
+
+// ✅ DFPlayer UART and the saved volume (setVolume waits 200 ms for the module)
+void bootDfplayer()
 {
-    Serial.begin(115200);
     Serial2.begin(9600, SERIAL_8N1, 16, 17);
+    setVolume(settings().volume);
+}
+
+// ✅ Replay partition; formatting it on first boot takes seconds
+void bootStorage()
+{
+    replayMount();
+}
 
-    setVolume(25);
-    server.on("/set-volume", HTTP_POST, []() {
-        String body = server.arg("plain");
-        Serial.println("🔊 Volume request received: " + body);
+// ✅ Connect to Wi-Fi in the background, the game works offline meanwhile
+void bootWifi()
+{
+    wifiBegin(targetSSID, password);
+    Serial.println("⏳ Connecting to Wi-Fi in background...");
+}
+
+// ✅ Every route, then the server; on loopTask, after Wi-Fi so /memory sees its tasks
+void bootRoutes()
+{
+    // ✅ Bodies may be JSON or MessagePack, picked by Content-Type
+    const char *headerKeys[] = {"Content-Type", "Accept", "If-None-Match"};
+    server.collectHeaders(headerKeys, 3);
+
+    // ✅ Prometheus /metrics; registered first so it can time every route below
+    metricsBegin(server);
+
+    metricsOn(server, "/set-volume", HTTP_POST, []() {
+        Serial.printf("🔊 Volume request received (%u bytes)\n", (unsigned)wireBodyLength());
     
-    JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, body);
+        RequestScope scope("set-volume");
+        JsonDocument doc(requestAllocator());
+        DeserializationError error = wireDecodeRequest(server, doc);
         if (error) {
             Serial.println("❌ Failed to parse JSON");
-            server.send(400, "application/json", "{\"error\": \"Invalid JSON\"}");
+            replyMessage(400, "error", "Invalid body");
             return;
         }
     
-        int volume = doc["volume"];
-        if (volume < 0 || volume > 30) {
-            server.send(400, "application/json", "{\"error\": \"Volume must be between 0 and 30\"}");
+        int volume;
+        FieldCheck check = checkVolumeFields(doc, volume);
+        if (check != FIELDS_OK) {
+            replyMessage(400, "error", FIELD_CHECK_ERRORS[check]);
             return;
         }
     
     setVolume(volume); // your existing function
+    if (Session *player = sessionActive()) // ✅ Session volume only, the cabinet default stays
+    {
+        player->volume = volume;
+    }
     lcd.clear();
     lcd.setCursor(0, 0);
     lcd.print("Volume set to:");
@@ -642,65 +1226,77 @@ void setup()
     delay(2000);
     volumeReceived = true;
     Serial.printf("✅ Volume set to %d\n", volume);
-    server.send(200, "application/json", "{\"message\": \"Volume set successfully\"}");
-    });
+    replyMessage(200, "message", "Volume set successfully");
+    }, []() { wireCaptureBody(server.raw()); });
 
-    // ✅ Initialize LCD
-    Wire.begin(LCD_SDA, LCD_SCL);
-    lcd.begin(16, 2);
-    lcd.backlight();
-    lcd.clear();
-    updateLCD("Booting Up...", "");
+    // ✅ Handle root request (login / volume page)
+    metricsOn(server, "/", HTTP_GET, handleRoot);
 
-    // ✅ Set button & LED pins
-    for (int i = 0; i < 5; i++)
-    {
-        pinMode(leds[i], OUTPUT);
-        pinMode(buttons[i], INPUT_PULLUP);
-    }
+    // ✅ Handle login request
+    metricsOn(server, "/esp-login", HTTP_POST, handleLoginRequest, []() { wireCaptureBody(server.raw()); });
+    metricsOn(server, "/esp-logout", HTTP_POST, handleLogoutRequest, []() { wireCaptureBody(server.raw()); });
+    metricsOn(server, "/queue", HTTP_GET, handleQueueRequest);
+    metricsOn(server, "/difficulty", HTTP_GET, handleDifficultyRequest);
 
-    // ✅ Connect to Wi-Fi
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(targetSSID, password);
+    // ✅ Live game events for the web app (Server-Sent Events)
+    telemetryBegin(server);
 
-    int retries = 0;
-    while (WiFi.status() != WL_CONNECTED && retries < 20)
-    {
-        delay(1000);
-        Serial.print("⏳ Connecting to Wi-Fi...");
-        retries++;
-    }
+    // ✅ Recent game replays on flash (/replays, /replay?slot=N)
+    replayBegin(server);
+    requestArenaBegin(server);
 
-    if (WiFi.status() == WL_CONNECTED)
-    {
-        Serial.println("\n✅ Connected to Wi-Fi!");
-        Serial.print("🌐 ESP32 IP Address: ");
-        Serial.println(WiFi.localIP());
+    // ✅ Saved settings (/settings, ?login=ask brings the boot prompts back)
+    settingsBegin(server);
 
-        delay(2000); // ✅ Allow time for stability
-        checkPing();
+    // ✅ Heap and per-task stack telemetry (/memory), after Wi-Fi so its tasks exist
+    memoryBegin(server);
 
-        // ✅ Handle root request
-        server.on("/", HTTP_GET, []()
-                  { server.send(200, "text/plain", "ESP32 Web Server Running!"); });
+    // ✅ Cycle counts per scope (/profile), only with -DSIMON_PROFILER
+    profilerBegin(server);
 
-        // ✅ Handle login request
-        server.on("/esp-login", HTTP_POST, handleLoginRequest);
+    // ✅ Timeline of the last 512 trace events (/trace), only with -DSIMON_TRACE
+    traceBegin(server);
 
-        server.begin();
-        Serial.println("✅ ESP Web Server Started! Listening for login data...");
-    }
-    else
+    // ✅ This boot's timeline (/boot)
+    bootBegin(server);
+
+    server.begin();
+    Serial.println("✅ ESP Web Server Started! Listening for login data...");
+}
+
+const BootStep BOOT_STEPS[STEP_COUNT] = {
+    {"settings", bootSettings, 0, BOOT_IN_TASK},
+    {"lcd", bootLcd, 0, BOOT_IN_TASK},
+    {"pins", bootPins, 0, BOOT_IN_TASK},
+    {"dfplayer", bootDfplayer, BOOT_AFTER(STEP_SETTINGS), BOOT_IN_TASK},
+    {"storage", bootStorage, 0, BOOT_IN_TASK},
+    {"wifi", bootWifi, 0, BOOT_IN_TASK},
+    {"routes", bootRoutes, BOOT_AFTER(STEP_WIFI), BOOT_ON_CALLER},
+};
+
+// ✅ Setup Function (Game + FastAPI Integration)
+void setup()
+{
+    Serial.begin(115200);
+    logBegin(); // ✅ Game-path log lines are formatted off the game loop from here on
+
+    // ✅ Cabinet ID sent with every score so the backend can tell devices apart
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(deviceID, sizeof(deviceID), "%012llX", (unsigned long long)mac);
+
+    // ✅ A slow step doesn't hold up the game: steps still waiting on it finish from serviceNetwork()
+    if (!bootRun(BOOT_STEPS, STEP_COUNT))
     {
-        Serial.println("\n❌ Failed to connect to Wi-Fi.");
+        Serial.println("⚠️ Boot incomplete after timeout, starting anyway");
     }
+    bootPrint(Serial);
 
     // ✅ Ask user for login
     askForLogin();
 }
 void loop()
 {
-    server.handleClient(); // ✅ Process incoming web requests
+    serviceNetwork(); // ✅ Keep Wi-Fi up and process incoming web requests
 
     // ✅ If no sound is chosen, ask again
     if (selectedFolder == 0)
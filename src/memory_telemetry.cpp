@@ -0,0 +1,189 @@
+#include "memory_telemetry.h"
+
+#include <esp_heap_caps.h>
+#include "fixed_string.h"
+#include "metrics.h"
+
+namespace
+{
+    const char *const POINT_NAMES[] = {"periodic", "round", "game_over", "request", "boot"};
+
+    struct WatchedTask
+    {
+        const char *name;
+        TaskHandle_t handle;
+    };
+
+    WatchedTask tasks[MEMORY_MAX_TASKS];
+    int taskCount = 0;
+
+    MemorySample ring[MEMORY_RING_SIZE];
+    int next = 0;
+    int stored = 0;
+    unsigned long lastPeriodicMs = 0;
+    bool warning = false;
+
+    WebServer *memoryServer = nullptr;
+
+    uint8_t fragmentationPct(const MemorySample &sample)
+    {
+        return sample.freeHeap ? 100 - (uint64_t)100 * sample.largestBlock / sample.freeHeap : 0;
+    }
+
+    // Name of the first watched task below the stack threshold, or nullptr.
+    const char *lowStackTask(const MemorySample &sample)
+    {
+        for (int i = 0; i < taskCount; i++)
+        {
+            if (sample.stackFree[i] < MEMORY_WARN_STACK_FREE)
+            {
+                return tasks[i].name;
+            }
+        }
+        return nullptr;
+    }
+
+    void checkThresholds(const MemorySample &sample)
+    {
+        const char *lowStack = lowStackTask(sample);
+        bool low = sample.freeHeap < MEMORY_WARN_FREE_HEAP || sample.largestBlock < MEMORY_WARN_LARGEST_BLOCK ||
+                   lowStack;
+        if (low && !warning)
+        {
+            Serial.printf("⚠️ Memory low at %s: %u free, %u largest block, stack %s\n", POINT_NAMES[sample.point],
+                          sample.freeHeap, sample.largestBlock, lowStack ? lowStack : "ok");
+        }
+        else if (!low && warning)
+        {
+            Serial.println("✅ Memory back above warning thresholds");
+        }
+        warning = low;
+    }
+
+    void handleMemory()
+    {
+        // About 140 bytes per sample plus the task names: streamed in pieces, not built whole.
+        FixedString<64 + MEMORY_MAX_TASKS * 24> head("{\"tasks\": [");
+        for (int i = 0; i < taskCount; i++)
+        {
+            head += i ? ", \"" : "\"";
+            head += tasks[i].name;
+            head += '"';
+        }
+        head += "], \"samples\": [";
+        memoryServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        memoryServer->send(200, "application/json", head.c_str());
+
+        for (int n = 0; n < stored; n++)
+        {
+            const MemorySample &s = ring[(next - stored + n + MEMORY_RING_SIZE) % MEMORY_RING_SIZE];
+            FixedString<96 + MEMORY_MAX_TASKS * 8> entry(n ? ", {\"ms\": " : "{\"ms\": ");
+            entry += s.atMs;
+            entry += ", \"at\": \"";
+            entry += POINT_NAMES[s.point];
+            entry += "\", \"free\": ";
+            entry += (unsigned long)s.freeHeap;
+            entry += ", \"min_free\": ";
+            entry += (unsigned long)s.minFreeHeap;
+            entry += ", \"largest\": ";
+            entry += (unsigned long)s.largestBlock;
+            entry += ", \"stack_free\": [";
+            for (int i = 0; i < taskCount; i++)
+            {
+                if (i)
+                {
+                    entry += ", ";
+                }
+                entry += (unsigned)s.stackFree[i];
+            }
+            entry += "]}";
+            memoryServer->sendContent(entry.c_str(), entry.length());
+        }
+        memoryServer->sendContent("]}", 2);
+        memoryServer->sendContent("", 0); // last chunk
+    }
+}
+
+void memoryWatchTask(const char *name, TaskHandle_t task)
+{
+    if (task && taskCount < MEMORY_MAX_TASKS)
+    {
+        tasks[taskCount++] = {name, task};
+    }
+}
+
+void memoryBegin(WebServer &server)
+{
+    memoryServer = &server;
+    metricsOn(server, "/memory", HTTP_GET, handleMemory);
+
+    memoryWatchTask("loopTask", xTaskGetCurrentTaskHandle());
+    memoryWatchTask("IDLE0", xTaskGetIdleTaskHandleForCPU(0));
+    memoryWatchTask("IDLE1", xTaskGetIdleTaskHandleForCPU(1));
+    memoryWatchTask("tiT", xTaskGetHandle("tiT"));   // lwIP
+    memoryWatchTask("wifi", xTaskGetHandle("wifi")); // only exists once Wi-Fi started
+    memorySample(MEMORY_BOOT);
+}
+
+const MemorySample &memorySample(MemoryPoint point)
+{
+    MemorySample &sample = ring[next];
+    sample.atMs = millis();
+    sample.point = point;
+    sample.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    sample.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    for (int i = 0; i < taskCount; i++)
+    {
+        UBaseType_t freeBytes = uxTaskGetStackHighWaterMark(tasks[i].handle); // bytes on ESP-IDF
+        sample.stackFree[i] = freeBytes > 0xffff ? 0xffff : freeBytes;
+    }
+
+    next = (next + 1) % MEMORY_RING_SIZE;
+    if (stored < MEMORY_RING_SIZE)
+    {
+        stored++;
+    }
+    checkThresholds(sample);
+    return sample;
+}
+
+void memoryPoll()
+{
+    if (millis() - lastPeriodicMs >= MEMORY_SAMPLE_INTERVAL_MS)
+    {
+        lastPeriodicMs = millis();
+        memorySample(MEMORY_PERIODIC);
+    }
+}
+
+int memoryTaskCount()
+{
+    return taskCount;
+}
+
+const char *memoryTaskName(int index)
+{
+    return index >= 0 && index < taskCount ? tasks[index].name : nullptr;
+}
+
+const MemorySample *memoryLatest()
+{
+    return stored ? &ring[(next - 1 + MEMORY_RING_SIZE) % MEMORY_RING_SIZE] : nullptr;
+}
+
+void memoryPrint(Print &out)
+{
+    const MemorySample *sample = memoryLatest();
+    if (!sample)
+    {
+        return;
+    }
+    out.printf("🧠 Heap: %u free (min %u), largest block %u, fragmentation %u%%; stack free:", sample->freeHeap,
+               sample->minFreeHeap, sample->largestBlock, fragmentationPct(*sample));
+    for (int i = 0; i < taskCount; i++)
+    {
+        out.printf(" %s %u", tasks[i].name, (unsigned)sample->stackFree[i]);
+    }
+    out.println();
+}
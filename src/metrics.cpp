@@ -0,0 +1,142 @@
+#include "metrics.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+#include "deferred_log.h"
+#include "idle_power.h"
+#include "profiler.h"
+#include "trace.h"
+#include "wifi_link.h"
+
+namespace
+{
+    MetricsRegistry registry = {};
+    WebServer *metricsServer = nullptr;
+
+    int pendingRoute = -1; // set by the probe, cleared by metricsRequestDone()
+    unsigned long pendingSince = 0;
+    uint32_t lastScrapeUs = 0;
+    uint32_t lastScrapeBytes = 0;
+
+    class RouteProbe : public RequestHandler
+    {
+    public:
+        bool canHandle(HTTPMethod, String uri) override
+        {
+            pendingRoute = metricsRouteIndex(registry, uri.c_str());
+            pendingSince = micros();
+            traceEnter(TRACE_HTTP_REQUEST, pendingRoute);
+            return false; // let the real handler take it
+        }
+    };
+    RouteProbe probe;
+
+    void addRoute(const char *uri)
+    {
+        if (!metricsAddRoute(registry, uri))
+        {
+            logDeferred<LOG_METRICS_ROUTES_FULL>(METRICS_MAX_ROUTES);
+        }
+    }
+
+    struct ChunkSink
+    {
+        void write(const char *data, size_t length) { metricsServer->sendContent(data, length); }
+    };
+
+    void handleMetrics()
+    {
+        ProfileScope profile(PROFILE_METRICS_SCRAPE);
+        unsigned long startedAt = micros();
+
+        const WifiStats &wifi = wifiStats();
+        MetricsGauges gauges;
+        gauges.wifiReconnects = wifi.reconnects;
+        gauges.wifiFailedAttempts = wifi.failedAttempts;
+        gauges.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        gauges.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+        gauges.uptimeUs = esp_timer_get_time();
+        gauges.lastScrapeUs = lastScrapeUs;
+        gauges.lastScrapeBytes = lastScrapeBytes;
+        gauges.logDropped = logDropped();
+        const IdleStats &idle = idleStats();
+        gauges.idleSleptUs = idle.sleptUs;
+        gauges.idleAwakeUs = idle.idleAwakeUs;
+        gauges.idleTimerWakes = idle.timerWakes;
+        gauges.idleButtonWakes = idle.buttonWakes;
+        gauges.idleWakeLatencyMaxUs = idle.maxWakeLatencyUs;
+        gauges.idleModelCurrentUa = idle.modelCurrentUa;
+        gauges.idlePowerMode = idle.powerMode;
+
+        metricsServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        metricsServer->send(200, "text/plain; version=0.0.4", "");
+        ChunkSink sink;
+        PrometheusWriter<ChunkSink> writer(sink);
+        renderMetrics(writer, registry, gauges);
+        metricsServer->sendContent("", 0); // last chunk
+
+        lastScrapeUs = micros() - startedAt;
+        lastScrapeBytes = writer.bytes();
+    }
+}
+
+void metricsBegin(WebServer &server)
+{
+    metricsServer = &server;
+    server.addHandler(&probe);
+    metricsOn(server, "/metrics", HTTP_GET, handleMetrics);
+}
+
+void metricsOn(WebServer &server, const char *uri, HTTPMethod method, WebServer::THandlerFunction handler)
+{
+    addRoute(uri);
+    server.on(uri, method, handler);
+}
+
+void metricsOn(WebServer &server, const char *uri, HTTPMethod method, WebServer::THandlerFunction handler,
+               WebServer::THandlerFunction upload)
+{
+    addRoute(uri);
+    server.on(uri, method, handler, upload);
+}
+
+bool metricsRequestDone()
+{
+    if (pendingRoute < 0)
+    {
+        return false;
+    }
+    registry.requestLatency[pendingRoute].observe(METRICS_LATENCY_BOUNDS_US, micros() - pendingSince);
+    traceLeave(TRACE_HTTP_REQUEST);
+    pendingRoute = -1;
+    return true;
+}
+
+void metricsButtonPress(int button)
+{
+    if (button >= 0 && button < METRICS_BUTTONS)
+    {
+        registry.buttonPresses[button]++;
+    }
+}
+
+void metricsDfplayerCommand()
+{
+    registry.dfplayerCommands++;
+}
+
+void metricsGamePlayed(uint32_t rounds, int score)
+{
+    registry.rounds.observe(METRICS_ROUND_BOUNDS, rounds);
+    registry.scores.observe(METRICS_SCORE_BOUNDS, score > 0 ? score : 0);
+}
+
+uint32_t metricsScoreUpload(MetricsUpload result, uint32_t latencyUs)
+{
+    if (latencyUs > 0)
+    {
+        registry.uploadLatency.observe(METRICS_UPLOAD_BOUNDS_US, latencyUs);
+    }
+    return ++registry.scoreUploads[result];
+}
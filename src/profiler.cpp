@@ -0,0 +1,167 @@
+#include "profiler.h"
+
+#include "metrics.h"
+#include "mpsc_ring.h"
+
+namespace
+{
+    const char *const PROFILE_NAMES[PROFILE_COUNT] = {
+        "simonTurn", "playerTurn", "playerPress", "updateLCD", "execute_CMD",
+        "handleClient", "telemetryPoll", "submitScore", "metricsScrape", "empty",
+    };
+    const int CORES = 2;
+    const int RING_SLOTS = PROFILER_ENABLED ? PROFILER_RING_SIZE : 1;
+
+    struct Event
+    {
+        ProfileId id;
+        uint32_t cycles;
+    };
+
+    struct Stats
+    {
+        uint32_t calls;
+        uint32_t minCycles;
+        uint32_t maxCycles;
+        uint64_t totalCycles;
+    };
+
+    MpscRing<Event, RING_SLOTS> rings[CORES];
+    Stats stats[CORES][PROFILE_COUNT];
+    uint32_t droppedAtReset[CORES] = {}; // the rings' drop counters only grow
+    uint32_t overheadCycles = 0;
+    WebServer *profileServer = nullptr;
+
+    void drain(int core)
+    {
+        Event event;
+        while (rings[core].pop(event)) // stops at a slot reserved but not written yet
+        {
+            Stats &s = stats[core][event.id];
+            if (s.calls == 0 || event.cycles < s.minCycles)
+            {
+                s.minCycles = event.cycles;
+            }
+            if (event.cycles > s.maxCycles)
+            {
+                s.maxCycles = event.cycles;
+            }
+            s.totalCycles += event.cycles;
+            s.calls++;
+        }
+    }
+
+    // One line per (core, scope) that ran, handed to emit(text, length).
+    template <class Emit>
+    void report(Emit emit)
+    {
+        char line[96];
+        int n = snprintf(line, sizeof(line), "%-16s %4s %7s %14s %14s %14s\n", "scope", "core", "calls",
+                         "min cycles", "mean cycles", "max cycles");
+        emit(line, n);
+        for (int core = 0; core < CORES; core++)
+        {
+            for (int id = 0; id < PROFILE_COUNT; id++)
+            {
+                const Stats &s = stats[core][id];
+                if (s.calls == 0 || id == PROFILE_EMPTY)
+                {
+                    continue;
+                }
+                n = snprintf(line, sizeof(line), "%-16s %4d %7u %14u %14llu %14u\n", PROFILE_NAMES[id], core,
+                             (unsigned)s.calls, (unsigned)s.minCycles,
+                             (unsigned long long)(s.totalCycles / s.calls), (unsigned)s.maxCycles);
+                emit(line, n);
+            }
+        }
+        n = snprintf(line, sizeof(line), "overhead %u cycles/scope, dropped %u + %u events, %u MHz\n",
+                     (unsigned)overheadCycles, (unsigned)(rings[0].dropped() - droppedAtReset[0]),
+                     (unsigned)(rings[1].dropped() - droppedAtReset[1]),
+                     (unsigned)getCpuFrequencyMhz());
+        emit(line, n);
+    }
+
+    void handleProfile()
+    {
+        if (profileServer->hasArg("reset"))
+        {
+            profilerReset();
+            profileServer->send(200, "text/plain", "profile cleared\n");
+            return;
+        }
+        if (!PROFILER_ENABLED)
+        {
+            profileServer->send(404, "text/plain", "profiler not built in (-DSIMON_PROFILER)\n");
+            return;
+        }
+        profilerPoll();
+        profileServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        profileServer->send(200, "text/plain", "");
+        report([](const char *line, size_t length) { profileServer->sendContent(line, length); });
+        profileServer->sendContent("", 0);
+    }
+}
+
+void profilerRecord(ProfileId id, uint32_t cycles)
+{
+    rings[xPortGetCoreID()].push({id, cycles});
+}
+
+void profilerBegin(WebServer &server)
+{
+    profileServer = &server;
+    metricsOn(server, "/profile", HTTP_GET, handleProfile);
+    if (!PROFILER_ENABLED)
+    {
+        return;
+    }
+
+    // Full cost of an empty scope: both counter reads, the call and the ring
+    // push. Fewer runs than ring slots, so nothing is dropped or drained
+    // inside the timed loop.
+    const int runs = 64;
+    static_assert(runs <= PROFILER_RING_SIZE, "calibration must fit in the ring");
+    profilerPoll();
+    uint32_t startedAt = ESP.getCycleCount();
+    for (int i = 0; i < runs; i++)
+    {
+        ProfileScope profile(PROFILE_EMPTY);
+    }
+    overheadCycles = (ESP.getCycleCount() - startedAt) / runs;
+    profilerPoll();
+    const Stats &empty = stats[xPortGetCoreID()][PROFILE_EMPTY];
+    Serial.printf("⏱️ Profiler on: %u cycles per empty scope (%u between its counter reads)\n",
+                  (unsigned)overheadCycles, (unsigned)(empty.calls ? empty.totalCycles / empty.calls : 0));
+}
+
+void profilerPoll()
+{
+    if (!PROFILER_ENABLED)
+    {
+        return;
+    }
+    for (int core = 0; core < CORES; core++)
+    {
+        drain(core);
+    }
+}
+
+void profilerReset()
+{
+    profilerPoll();
+    memset(stats, 0, sizeof(stats));
+    for (int core = 0; core < CORES; core++)
+    {
+        droppedAtReset[core] = rings[core].dropped();
+    }
+}
+
+void profilerPrint(Print &out)
+{
+    if (!PROFILER_ENABLED)
+    {
+        return;
+    }
+    profilerPoll();
+    report([&out](const char *line, size_t length) { out.write((const uint8_t *)line, length); });
+}
@@ -0,0 +1,239 @@
+#include "replay.h"
+
+#include <FS.h>
+#include <LittleFS.h>
+#include "fixed_string.h"
+#include "metrics.h"
+
+namespace
+{
+    const uint8_t CODE_STEP = 5;
+    const uint8_t CODE_GAME_OVER = 15;
+
+    WebServer *replayServer = nullptr;
+    bool mounted = false;
+
+    uint32_t nextGame = 0;
+    File current;
+    uint8_t buffer[REPLAY_BUFFER_SIZE];
+    int buffered = 0;
+    unsigned long lastRecordMs = 0;
+
+    // Per-game write cost, reported when the game ends.
+    uint32_t bytesWritten = 0;
+    uint32_t flashWrites = 0;
+    unsigned long flashMicros = 0;
+    uint32_t forcedFlushes = 0;
+
+    void slotPath(char *path, size_t size, int slot)
+    {
+        snprintf(path, size, "/replays/%d.bin", slot);
+    }
+
+    // Returns the game number stored in a slot, or -1 if it is empty.
+    long readGameNumber(int slot)
+    {
+        char path[24];
+        slotPath(path, sizeof(path), slot);
+        File f = LittleFS.open(path, "r");
+        if (!f)
+        {
+            return -1;
+        }
+        uint8_t header[8];
+        long game = -1;
+        if (f.read(header, sizeof(header)) == sizeof(header) && memcmp(header, "SSR1", 4) == 0)
+        {
+            game = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+        }
+        f.close();
+        return game;
+    }
+
+    void writeBuffer()
+    {
+        if (!current || buffered == 0)
+        {
+            buffered = 0;
+            return;
+        }
+        unsigned long startedAt = micros();
+        current.write(buffer, buffered);
+        flashMicros += micros() - startedAt;
+        bytesWritten += buffered;
+        flashWrites++;
+        buffered = 0;
+    }
+
+    void put(uint8_t byte)
+    {
+        if (buffered == REPLAY_BUFFER_SIZE)
+        {
+            // Only very long rounds get here; better a late write than a lost record.
+            forcedFlushes++;
+            writeBuffer();
+        }
+        buffer[buffered++] = byte;
+    }
+
+    void putVarint(uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            put((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        put((uint8_t)value);
+    }
+
+    void putU32(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            put((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    void record(uint8_t code)
+    {
+        if (!current)
+        {
+            return;
+        }
+        unsigned long now = millis();
+        putVarint(((now - lastRecordMs) << 4) | code);
+        lastRecordMs = now;
+    }
+
+    void handleList()
+    {
+        FixedString<REPLAY_SLOTS * 56> json("[");
+        for (int slot = 0; slot < REPLAY_SLOTS; slot++)
+        {
+            long game = readGameNumber(slot);
+            if (game < 0)
+            {
+                continue;
+            }
+            char path[24];
+            slotPath(path, sizeof(path), slot);
+            File f = LittleFS.open(path, "r");
+            json += json.length() > 1 ? ", {\"slot\": " : "{\"slot\": ";
+            json += slot;
+            json += ", \"game\": ";
+            json += game;
+            json += ", \"bytes\": ";
+            json += (unsigned long)f.size();
+            json += '}';
+            f.close();
+        }
+        json += ']';
+        replayServer->send(200, "application/json", json.c_str());
+    }
+
+    void handleDownload()
+    {
+        int slot = replayServer->arg("slot").toInt();
+        char path[24];
+        slotPath(path, sizeof(path), slot);
+        if (!mounted || slot < 0 || slot >= REPLAY_SLOTS || !LittleFS.exists(path))
+        {
+            replayServer->send(404, "text/plain", "No such replay");
+            return;
+        }
+        File f = LittleFS.open(path, "r");
+        replayServer->streamFile(f, "application/octet-stream");
+        f.close();
+    }
+}
+
+void replayBegin(WebServer &server)
+{
+    replayServer = &server;
+    metricsOn(server, "/replays", HTTP_GET, handleList);
+    metricsOn(server, "/replay", HTTP_GET, handleDownload);
+}
+
+void replayMount()
+{
+    mounted = LittleFS.begin(true); // formats the data partition on first use
+    if (!mounted)
+    {
+        Serial.println("❌ LittleFS mount failed, replays disabled");
+        return;
+    }
+    LittleFS.mkdir("/replays");
+
+    // Continue numbering after the newest replay already on flash.
+    for (int slot = 0; slot < REPLAY_SLOTS; slot++)
+    {
+        long game = readGameNumber(slot);
+        if (game >= 0 && (uint32_t)game >= nextGame)
+        {
+            nextGame = game + 1;
+        }
+    }
+}
+
+void replayStart(uint32_t seed, int folder, int mode)
+{
+    if (!mounted)
+    {
+        return;
+    }
+    if (current)
+    {
+        current.close(); // previous game never finished
+    }
+
+    char path[24];
+    slotPath(path, sizeof(path), nextGame % REPLAY_SLOTS);
+    current = LittleFS.open(path, "w"); // overwrites the oldest game
+    buffered = 0;
+    bytesWritten = flashWrites = forcedFlushes = 0;
+    flashMicros = 0;
+    lastRecordMs = millis();
+
+    put('S');
+    put('S');
+    put('R');
+    put('1');
+    putU32(nextGame);
+    putU32(seed);
+    put((uint8_t)folder);
+    put((uint8_t)mode);
+    nextGame++;
+}
+
+void replayStep(uint8_t button)
+{
+    record(CODE_STEP + button);
+}
+
+void replayPress(uint8_t button)
+{
+    record(button);
+}
+
+void replayFlush()
+{
+    writeBuffer();
+}
+
+void replayFinish(int score)
+{
+    if (!current)
+    {
+        return;
+    }
+    record(CODE_GAME_OVER);
+    putVarint(score);
+    writeBuffer();
+
+    unsigned long startedAt = micros();
+    current.close();
+    flashMicros += micros() - startedAt;
+
+    Serial.printf("💾 Replay saved: %u bytes, %u flash writes (%u forced), %lu us writing\n",
+                  bytesWritten, flashWrites, forcedFlushes, flashMicros);
+}
@@ -0,0 +1,114 @@
+#include "request_arena.h"
+
+#include "bump_arena.h"
+#include "fixed_string.h"
+#include "memory_telemetry.h"
+#include "metrics.h"
+
+namespace
+{
+    alignas(max_align_t) uint8_t memory[REQUEST_ARENA_SIZE];
+    BumpArena arena(memory, sizeof(memory));
+    int depth = 0;
+
+    RequestArenaTag tags[REQUEST_ARENA_TAGS];
+    int tagCount = 0;
+    WebServer *arenaServer = nullptr;
+
+    class ArenaJsonAllocator : public ArduinoJson::Allocator
+    {
+    public:
+        void *allocate(size_t size) override { return arena.allocate(size); }
+        void deallocate(void *) override {} // released with the whole scope
+        void *reallocate(void *ptr, size_t size) override { return arena.reallocate(ptr, size); }
+    };
+    ArenaJsonAllocator jsonAllocator;
+
+    RequestArenaTag *findTag(const char *tag)
+    {
+        for (int i = 0; i < tagCount; i++)
+        {
+            if (strcmp(tags[i].tag, tag) == 0)
+            {
+                return &tags[i];
+            }
+        }
+        if (tagCount == REQUEST_ARENA_TAGS)
+        {
+            return nullptr;
+        }
+        tags[tagCount] = {tag, 0, 0, 0};
+        return &tags[tagCount++];
+    }
+
+    void handleArena()
+    {
+        FixedString<96 + REQUEST_ARENA_TAGS * 96> json("{\"capacity\": ");
+        json += (unsigned long)arena.capacity();
+        json += ", \"requests\": [";
+        for (int i = 0; i < tagCount; i++)
+        {
+            json += i ? ", {\"tag\": \"" : "{\"tag\": \"";
+            json += tags[i].tag;
+            json += "\", \"count\": ";
+            json += (unsigned long)tags[i].requests;
+            json += ", \"peak_bytes\": ";
+            json += (unsigned long)tags[i].peakBytes;
+            json += ", \"exhaustions\": ";
+            json += (unsigned long)tags[i].exhaustions;
+            json += '}';
+        }
+        json += "]}";
+        arenaServer->send(200, "application/json", json.c_str());
+    }
+}
+
+void requestArenaBegin(WebServer &server)
+{
+    arenaServer = &server;
+    metricsOn(server, "/arena", HTTP_GET, handleArena);
+}
+
+ArduinoJson::Allocator *requestAllocator()
+{
+    return &jsonAllocator;
+}
+
+const RequestArenaTag *requestArenaTag(int index)
+{
+    return index >= 0 && index < tagCount ? &tags[index] : nullptr;
+}
+
+RequestScope::RequestScope(const char *tag) : tag_(tag), failuresAtStart_(arena.failures())
+{
+    if (depth++ == 0)
+    {
+        arena.reset();
+        arena.resetPeak();
+    }
+}
+
+RequestScope::~RequestScope()
+{
+    if (--depth > 0)
+    {
+        return;
+    }
+    uint32_t exhausted = arena.failures() - failuresAtStart_;
+    if (RequestArenaTag *entry = findTag(tag_))
+    {
+        entry->requests++;
+        if (arena.peak() > entry->peakBytes)
+        {
+            entry->peakBytes = arena.peak();
+        }
+        entry->exhaustions += exhausted ? 1 : 0;
+    }
+    if (exhausted)
+    {
+        Serial.printf("⚠️ Request arena exhausted in %s (%u failed allocations, %u bytes)\n", tag_,
+                      (unsigned)exhausted, (unsigned)arena.capacity());
+    }
+    arena.reset();
+    memorySample(MEMORY_REQUEST_END);
+}
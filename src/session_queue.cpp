@@ -0,0 +1,105 @@
+#include "session_queue.h"
+
+namespace
+{
+    // Ring buffer of waiting players, plus the one currently playing.
+    Session waiting[SESSION_CAPACITY];
+    int head = 0;
+    int count = 0;
+
+    Session active;
+    bool hasActive = false;
+
+    void fill(Session &slot, long userId, const char *username, int volume, int folder)
+    {
+        slot.userId = userId;
+        strncpy(slot.username, username, SESSION_NAME_LEN);
+        slot.username[SESSION_NAME_LEN] = '\0';
+        slot.volume = volume;
+        slot.folder = folder;
+    }
+}
+
+int sessionEnqueue(long userId, const char *username, int volume, int folder)
+{
+    if (hasActive && active.userId == userId)
+    {
+        fill(active, userId, username, volume, folder);
+        return SESSION_PLAYING;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        Session &queued = waiting[(head + i) % SESSION_CAPACITY];
+        if (queued.userId == userId)
+        {
+            fill(queued, userId, username, volume, folder);
+            return i + 1;
+        }
+    }
+    if (count == SESSION_CAPACITY)
+    {
+        return 0;
+    }
+
+    fill(waiting[(head + count) % SESSION_CAPACITY], userId, username, volume, folder);
+    count++;
+    return count;
+}
+
+Session *sessionActive()
+{
+    return hasActive ? &active : nullptr;
+}
+
+Session *sessionAdvance()
+{
+    if (count == 0)
+    {
+        hasActive = false;
+        return nullptr;
+    }
+
+    active = waiting[head];
+    head = (head + 1) % SESSION_CAPACITY;
+    count--;
+    hasActive = true;
+    return &active;
+}
+
+bool sessionLogout(long userId)
+{
+    if (hasActive && active.userId == userId)
+    {
+        hasActive = false;
+        return true;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (waiting[(head + i) % SESSION_CAPACITY].userId != userId)
+        {
+            continue;
+        }
+        // Close the gap, keeping everyone behind in order
+        for (int j = i; j + 1 < count; j++)
+        {
+            waiting[(head + j) % SESSION_CAPACITY] = waiting[(head + j + 1) % SESSION_CAPACITY];
+        }
+        count--;
+        return true;
+    }
+    return false;
+}
+
+int sessionWaiting()
+{
+    return count;
+}
+
+const Session *sessionPeek(int position)
+{
+    if (position < 0 || position >= count)
+    {
+        return nullptr;
+    }
+    return &waiting[(head + position) % SESSION_CAPACITY];
+}
@@ -0,0 +1,145 @@
+#include "settings.h"
+
+#include <Preferences.h>
+
+#include "boot.h"
+#include "deferred_log.h"
+#include "metrics.h"
+
+namespace
+{
+    const uint32_t SETTINGS_MAGIC = 0x53455431; // "SET1"
+    const char *const LOGIN_NAMES[] = {"ask", "web", "offline"};
+
+    DeviceSettings current = {SETTINGS_MAGIC, 0, SETTINGS_DEFAULT_VOLUME, 0, LOGIN_ASK, 0};
+    bool restored = false;
+    bool dirty = false;
+    unsigned long changedAt = 0;
+    unsigned long bootToPlayableMs = 0;
+    uint32_t writes = 0;
+    WebServer *settingsServer = nullptr;
+
+    template <class T>
+    void update(T &field, T value)
+    {
+        if (field == value)
+        {
+            return; // nothing to write
+        }
+        field = value;
+        dirty = true;
+        changedAt = millis();
+    }
+
+    void handleSettings()
+    {
+        if (settingsServer->hasArg("login"))
+        {
+            String login = settingsServer->arg("login");
+            for (int i = 0; i < 3; i++)
+            {
+                if (login == LOGIN_NAMES[i])
+                {
+                    settingsSetLogin((LoginPreference)i);
+                }
+            }
+        }
+
+        char reply[256];
+        snprintf(reply, sizeof(reply),
+                 "{\"folder\":%u,\"volume\":%u,\"mode\":%u,\"difficultyTarget\":%.2f,\"login\":\"%s\","
+                 "\"restored\":%s,\"pendingWrite\":%s,\"writes\":%u,\"bootToPlayableMs\":%lu}",
+                 current.folder, current.volume, current.mode, current.difficultyTarget,
+                 LOGIN_NAMES[current.login < 3 ? current.login : 0], restored ? "true" : "false",
+                 dirty ? "true" : "false", (unsigned)writes, bootToPlayableMs);
+        settingsServer->send(200, "application/json", reply);
+    }
+}
+
+void settingsLoad()
+{
+    DeviceSettings stored;
+    Preferences prefs;
+    prefs.begin("settings", true);
+    restored = prefs.getBytesLength("device") == sizeof(stored) &&
+               prefs.getBytes("device", &stored, sizeof(stored)) == sizeof(stored) && stored.magic == SETTINGS_MAGIC;
+    prefs.end();
+    if (restored)
+    {
+        current = stored;
+    }
+    logDeferred<LOG_SETTINGS_LOADED>((unsigned)restored, (unsigned)current.folder, (unsigned)current.volume,
+                                     (unsigned)current.login);
+}
+
+void settingsBegin(WebServer &server)
+{
+    settingsServer = &server;
+    metricsOn(server, "/settings", HTTP_GET, handleSettings);
+}
+
+const DeviceSettings &settings()
+{
+    return current;
+}
+
+bool settingsRestored()
+{
+    return restored;
+}
+
+void settingsSetFolder(int folder)
+{
+    update(current.folder, (uint8_t)folder);
+}
+
+void settingsSetVolume(int volume)
+{
+    update(current.volume, (uint8_t)volume);
+}
+
+void settingsSetMode(int mode)
+{
+    update(current.mode, (uint8_t)mode);
+}
+
+void settingsSetDifficultyTarget(float target)
+{
+    update(current.difficultyTarget, target);
+}
+
+void settingsSetLogin(LoginPreference login)
+{
+    update(current.login, (uint8_t)login);
+}
+
+void settingsPoll()
+{
+    if (!dirty || millis() - changedAt < SETTINGS_WRITE_DELAY_MS)
+    {
+        return;
+    }
+    dirty = false;
+    unsigned long startedAt = micros();
+    Preferences prefs;
+    prefs.begin("settings", false);
+    prefs.putBytes("device", &current, sizeof(current));
+    prefs.end();
+    writes++;
+    logDeferred<LOG_SETTINGS_SAVED>(micros() - startedAt);
+}
+
+void settingsMarkPlayable()
+{
+    if (bootToPlayableMs == 0)
+    {
+        bootToPlayableMs = millis();
+        bootMark("playable");
+        logDeferred<LOG_BOOT_PLAYABLE>(bootToPlayableMs, (unsigned)restored);
+    }
+}
+
+unsigned long settingsBootToPlayableMs()
+{
+    return bootToPlayableMs;
+}
@@ -0,0 +1,169 @@
+#include "telemetry.h"
+
+#include <WiFi.h>
+#include <lwip/sockets.h>
+
+#include "metrics.h"
+#include "sse_stream.h"
+
+namespace
+{
+    const unsigned long KEEPALIVE_INTERVAL_MS = 15000;
+
+    struct Subscriber
+    {
+        WiFiClient client;
+        bool active = false;
+        SseQueue<TELEMETRY_QUEUE_SIZE> queue;
+    };
+
+    WebServer *eventServer = nullptr;
+    Subscriber subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+
+    SseFrame<TELEMETRY_FRAME_SIZE> frame;
+    unsigned long lastKeepaliveMs = 0;
+
+    void dropSubscriber(Subscriber &sub, const char *reason)
+    {
+        sub.client.stop();
+        sub.client = WiFiClient();
+        sub.active = false;
+        sub.queue.clear();
+        Serial.print("📡 Telemetry client dropped: ");
+        Serial.println(reason);
+    }
+
+    // Push as much of the queue as the socket accepts right now.
+    void drain(Subscriber &sub)
+    {
+        int fd = sub.client.fd();
+        SseDrain result = sub.queue.drain([fd](const char *data, int length) {
+            return (int)send(fd, data, length, MSG_DONTWAIT);
+        });
+        if (result == SSE_CLOSED)
+        {
+            dropSubscriber(sub, "socket closed");
+        }
+    }
+
+    void broadcast(const char *data, int length)
+    {
+        for (Subscriber &sub : subscribers)
+        {
+            if (!sub.active)
+            {
+                continue;
+            }
+            if (!sub.queue.enqueue(data, length))
+            {
+                dropSubscriber(sub, "send queue full");
+                continue;
+            }
+            drain(sub);
+        }
+    }
+
+    void appendEvent(TelemetryEvent event, const int *fields, int count)
+    {
+        if (!frame.append((char)event, fields, count))
+        {
+            // Flush early rather than lose events when a frame is unusually busy.
+            telemetryPoll();
+            frame.append((char)event, fields, count);
+        }
+    }
+
+    void handleSubscribe()
+    {
+        for (Subscriber &sub : subscribers)
+        {
+            if (sub.active)
+            {
+                continue;
+            }
+            sub.client = eventServer->client();
+            sub.client.setNoDelay(true);
+            sub.client.print("HTTP/1.1 200 OK\r\n"
+                             "Content-Type: text/event-stream\r\n"
+                             "Cache-Control: no-cache\r\n"
+                             "Connection: keep-alive\r\n"
+                             "Access-Control-Allow-Origin: *\r\n\r\n"
+                             "retry: 2000\n\n");
+            sub.active = true;
+            sub.queue.clear();
+            Serial.printf("📡 Telemetry client subscribed (%d active)\n", telemetrySubscriberCount());
+            return;
+        }
+        eventServer->send(503, "text/plain", "Too many telemetry subscribers");
+    }
+}
+
+void telemetryBegin(WebServer &server)
+{
+    eventServer = &server;
+    metricsOn(server, "/events", HTTP_GET, handleSubscribe);
+}
+
+void telemetryEmit(TelemetryEvent event, int a)
+{
+    int fields[] = {a};
+    appendEvent(event, fields, 1);
+}
+
+void telemetryEmit(TelemetryEvent event, int a, int b)
+{
+    int fields[] = {a, b};
+    appendEvent(event, fields, 2);
+}
+
+void telemetryEmit(TelemetryEvent event, int a, int b, int c)
+{
+    int fields[] = {a, b, c};
+    appendEvent(event, fields, 3);
+}
+
+// ✅ Called once per frame: send the coalesced events and keep slow clients moving
+void telemetryPoll()
+{
+    if (telemetrySubscriberCount() == 0)
+    {
+        frame.clear();
+        return;
+    }
+
+    if (!frame.empty())
+    {
+        char message[SseFrame<TELEMETRY_FRAME_SIZE>::MESSAGE_SIZE];
+        int n = frame.message(message);
+        broadcast(message, n);
+        lastKeepaliveMs = millis();
+    }
+    else if (millis() - lastKeepaliveMs > KEEPALIVE_INTERVAL_MS)
+    {
+        broadcast(":\n\n", 3); // SSE comment, detects dead connections
+        lastKeepaliveMs = millis();
+    }
+    else
+    {
+        for (Subscriber &sub : subscribers)
+        {
+            if (sub.active)
+            {
+                drain(sub);
+            }
+        }
+    }
+}
+
+int telemetrySubscriberCount()
+{
+    int count = 0;
+    for (const Subscriber &sub : subscribers)
+    {
+        if (sub.active)
+        {
+            count++;
+        }
+    }
+    return count;
+}
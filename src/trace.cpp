@@ -0,0 +1,166 @@
+#include "trace.h"
+
+#include <atomic>
+#include <esp_timer.h>
+
+#include "metrics.h"
+
+namespace
+{
+    const char *const TRACE_NAMES[TRACE_NAME_COUNT] = {
+        "simonTurn", "playerTurn", "playerPress", "playInFolder", "execute_CMD", "updateLCD", "httpRequest",
+        "submitScore", "scorePost", "roundStart", "gameOver", "wifiLost", "wifiUp",
+    };
+    const int RING_SLOTS = TRACE_ENABLED ? TRACE_RING_SIZE : 1;
+    const size_t CHUNK_SIZE = 512;
+    const size_t EVENT_TEXT_MAX = 160;
+
+    struct Event
+    {
+        std::atomic<uint32_t> sequence; // slot number + 1 once written, 0 while being rewritten
+        uint32_t atUs;
+        uint32_t arg;
+        uint16_t name;
+        char phase;
+        uint8_t core;
+    };
+
+    std::atomic<uint32_t> head{0}; // next slot to write
+    uint32_t clearedAt = 0;        // slots before this were cleared
+    Event ring[RING_SLOTS];
+    WebServer *traceServer = nullptr;
+
+    // Copies slot `index` unless it was overwritten or is being written right now.
+    bool readEvent(uint32_t index, Event &out)
+    {
+        Event &event = ring[index % RING_SLOTS];
+        uint32_t sequence = event.sequence.load(std::memory_order_acquire);
+        if (sequence != index + 1)
+        {
+            return false;
+        }
+        out.atUs = event.atUs;
+        out.arg = event.arg;
+        out.name = event.name;
+        out.phase = event.phase;
+        out.core = event.core;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return event.sequence.load(std::memory_order_relaxed) == sequence && out.name < TRACE_NAME_COUNT;
+    }
+
+    class ChunkWriter
+    {
+    public:
+        void append(const char *text, size_t length)
+        {
+            if (used_ + length > sizeof(buffer_))
+            {
+                flush();
+            }
+            memcpy(buffer_ + used_, text, length);
+            used_ += length;
+        }
+
+        // Room for one more event line without a flush in the middle.
+        void reserve()
+        {
+            if (sizeof(buffer_) - used_ < EVENT_TEXT_MAX)
+            {
+                flush();
+            }
+        }
+
+        char *tail() { return buffer_ + used_; }
+        void commit(size_t length) { used_ += length; }
+
+        void flush()
+        {
+            if (used_)
+            {
+                traceServer->sendContent(buffer_, used_);
+                used_ = 0;
+            }
+        }
+
+    private:
+        char buffer_[CHUNK_SIZE];
+        size_t used_ = 0;
+    };
+
+    void handleTrace()
+    {
+        if (traceServer->hasArg("clear"))
+        {
+            clearedAt = head.load(std::memory_order_acquire);
+            traceServer->send(200, "text/plain", "trace cleared\n");
+            return;
+        }
+        if (!TRACE_ENABLED)
+        {
+            traceServer->send(404, "text/plain", "tracing not built in (-DSIMON_TRACE)\n");
+            return;
+        }
+
+        uint32_t end = head.load(std::memory_order_acquire);
+        uint32_t start = end - clearedAt < (uint32_t)RING_SLOTS ? clearedAt : end - RING_SLOTS;
+        int64_t nowUs = esp_timer_get_time();
+
+        traceServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        traceServer->send(200, "application/json", "");
+        ChunkWriter out;
+        static const char HEADER[] =
+            "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"SmartSimon\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"core 0 (Wi-Fi)\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"core 1 (game loop)\"}}";
+        out.append(HEADER, sizeof(HEADER) - 1);
+
+        for (uint32_t index = start; index != end; index++)
+        {
+            Event event;
+            if (!readEvent(index, event))
+            {
+                continue;
+            }
+            // Signed distance to now, so events stamped just after `end` was read still land right.
+            int64_t atUs = nowUs - (int32_t)((uint32_t)nowUs - event.atUs);
+            out.reserve();
+            int n = snprintf(out.tail(), EVENT_TEXT_MAX, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u",
+                             TRACE_NAMES[event.name], event.phase, (long long)atUs, (unsigned)event.core);
+            if (event.phase == 'B' || event.phase == 'i')
+            {
+                n += snprintf(out.tail() + n, EVENT_TEXT_MAX - n, event.phase == 'i' ? ",\"s\":\"t\",\"args\":{\"arg\":%u}}"
+                                                                                      : ",\"args\":{\"arg\":%u}}",
+                              (unsigned)event.arg);
+            }
+            else
+            {
+                out.tail()[n++] = '}';
+            }
+            out.commit(n);
+        }
+        out.append("\n]}\n", 4);
+        out.flush();
+        traceServer->sendContent("", 0); // last chunk
+    }
+}
+
+void traceRecord(TraceName name, char phase, uint32_t arg)
+{
+    uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Event &event = ring[index % RING_SLOTS];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.atUs = (uint32_t)esp_timer_get_time();
+    event.arg = arg;
+    event.name = name;
+    event.phase = phase;
+    event.core = xPortGetCoreID();
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+void traceBegin(WebServer &server)
+{
+    traceServer = &server;
+    metricsOn(server, "/trace", HTTP_GET, handleTrace);
+}
@@ -0,0 +1,249 @@
+#include "wifi_link.h"
+
+#include <WiFi.h>
+#include <Preferences.h>
+
+#include "deferred_log.h"
+#include "trace.h"
+
+namespace
+{
+    const unsigned long FAST_CONNECT_TIMEOUT_MS = 4000;
+    const unsigned long FULL_CONNECT_TIMEOUT_MS = 15000;
+    const unsigned long MIN_BACKOFF_MS = 1000;
+    const unsigned long MAX_BACKOFF_MS = 30000;
+    const uint32_t CACHE_MAGIC = 0x57494631; // "WIF1"
+
+    // Stored as one NVS blob so a load is a single read.
+    struct LinkCache
+    {
+        uint32_t magic;
+        uint8_t bssid[6];
+        int32_t channel;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+    };
+
+    const char *wifiSsid = nullptr;
+    const char *wifiPassword = nullptr;
+
+    WifiState state = WIFI_LINK_IDLE;
+    WifiStats stats = {};
+    LinkCache cache = {};
+    bool cacheValid = false;
+    bool cacheDirty = false; // captured on connect, not yet in NVS
+    bool everConnected = false;
+
+    unsigned long attemptStartedAt = 0;
+    unsigned long linkLostAt = 0;
+    unsigned long backoffUntil = 0;
+    unsigned long backoffMs = MIN_BACKOFF_MS;
+
+    void loadCache()
+    {
+        Preferences prefs;
+        prefs.begin("wifi", true);
+        cacheValid = prefs.getBytesLength("link") == sizeof(cache) &&
+                     prefs.getBytes("link", &cache, sizeof(cache)) == sizeof(cache) &&
+                     cache.magic == CACHE_MAGIC;
+        prefs.end();
+    }
+
+    // Captures the link for the next reconnect; wifiFlushCache() writes it.
+    void captureCache()
+    {
+        LinkCache fresh = {};
+        fresh.magic = CACHE_MAGIC;
+        memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+        fresh.channel = WiFi.channel();
+        fresh.ip = WiFi.localIP();
+        fresh.gateway = WiFi.gatewayIP();
+        fresh.subnet = WiFi.subnetMask();
+        fresh.dns = WiFi.dnsIP();
+
+        // Only touch flash when something actually changed.
+        if (cacheValid && memcmp(&fresh, &cache, sizeof(cache)) == 0)
+        {
+            return;
+        }
+        cache = fresh;
+        cacheValid = true;
+        cacheDirty = true;
+    }
+
+    void startAttempt(bool useCache)
+    {
+        WiFi.disconnect();
+        stats.lastAttemptUsedCache = useCache;
+        if (useCache)
+        {
+            // Reuse the previous lease and skip the channel scan.
+            WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+            WiFi.begin(wifiSsid, wifiPassword, cache.channel, cache.bssid);
+        }
+        else
+        {
+            WiFi.config(IPAddress(), IPAddress(), IPAddress()); // back to DHCP
+            WiFi.begin(wifiSsid, wifiPassword);
+        }
+        attemptStartedAt = millis();
+        state = WIFI_LINK_CONNECTING;
+    }
+
+    void attemptFailed()
+    {
+        stats.failedAttempts++;
+        if (stats.lastAttemptUsedCache)
+        {
+            // The AP moved or the lease is gone: retry straight away with a full connect.
+            logDeferred<LOG_WIFI_CACHE_FAILED>();
+            cacheValid = false;
+            startAttempt(false);
+            return;
+        }
+        WiFi.disconnect();
+        backoffUntil = millis() + backoffMs;
+        logDeferred<LOG_WIFI_RETRY>(backoffMs);
+        backoffMs = min(backoffMs * 2, MAX_BACKOFF_MS);
+        state = WIFI_LINK_BACKOFF;
+    }
+
+    void onConnected()
+    {
+        unsigned long now = millis();
+        stats.lastConnectMs = now - attemptStartedAt;
+        if (!everConnected)
+        {
+            stats.firstConnectMs = now;
+            everConnected = true;
+        }
+        else
+        {
+            stats.lastReconnectMs = now - linkLostAt;
+            stats.reconnects++;
+        }
+        backoffMs = MIN_BACKOFF_MS;
+        state = WIFI_LINK_CONNECTED;
+        captureCache();
+
+        traceInstant(TRACE_WIFI_UP, stats.lastConnectMs);
+        if (stats.lastAttemptUsedCache)
+        {
+            logDeferred<LOG_WIFI_UP_CACHED>(stats.lastConnectMs);
+        }
+        else
+        {
+            logDeferred<LOG_WIFI_UP_FULL>(stats.lastConnectMs);
+        }
+        if (stats.reconnects > 0)
+        {
+            logDeferred<LOG_WIFI_RECONNECTED>(stats.lastReconnectMs, stats.reconnects);
+        }
+    }
+
+    void linkLost()
+    {
+        logDeferred<LOG_WIFI_LOST>();
+        traceInstant(TRACE_WIFI_LOST);
+        linkLostAt = millis();
+    }
+}
+
+void wifiBegin(const char *ssid, const char *password)
+{
+    wifiSsid = ssid;
+    wifiPassword = password;
+
+    WiFi.persistent(false); // we keep our own cache, don't let the driver rewrite flash
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+
+    loadCache();
+    startAttempt(cacheValid);
+}
+
+bool wifiPoll()
+{
+    bool linkUp = WiFi.status() == WL_CONNECTED;
+
+    switch (state)
+    {
+    case WIFI_LINK_IDLE:
+        break;
+
+    case WIFI_LINK_CONNECTING:
+    {
+        if (linkUp)
+        {
+            onConnected();
+            return true;
+        }
+        unsigned long timeout = stats.lastAttemptUsedCache ? FAST_CONNECT_TIMEOUT_MS : FULL_CONNECT_TIMEOUT_MS;
+        if (millis() - attemptStartedAt > timeout)
+        {
+            attemptFailed();
+        }
+        break;
+    }
+
+    case WIFI_LINK_CONNECTED:
+        if (!linkUp)
+        {
+            linkLost();
+            startAttempt(cacheValid);
+        }
+        break;
+
+    case WIFI_LINK_BACKOFF:
+        if ((long)(millis() - backoffUntil) >= 0)
+        {
+            startAttempt(cacheValid);
+        }
+        break;
+    }
+    return false;
+}
+
+void wifiWatch()
+{
+    if (state == WIFI_LINK_CONNECTED && WiFi.status() != WL_CONNECTED)
+    {
+        linkLost();
+        backoffUntil = millis(); // reconnect on the first wifiPoll() after the round
+        state = WIFI_LINK_BACKOFF;
+    }
+}
+
+void wifiFlushCache()
+{
+    if (!cacheDirty)
+    {
+        return;
+    }
+    cacheDirty = false;
+    if (!cacheValid)
+    {
+        return; // the captured link failed a fast reconnect since; keep the old copy
+    }
+    Preferences prefs;
+    prefs.begin("wifi", false);
+    prefs.putBytes("link", &cache, sizeof(cache));
+    prefs.end();
+}
+
+bool wifiConnected()
+{
+    return state == WIFI_LINK_CONNECTED;
+}
+
+WifiState wifiState()
+{
+    return state;
+}
+
+const WifiStats &wifiStats()
+{
+    return stats;
+}
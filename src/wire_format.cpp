@@ -0,0 +1,81 @@
+#include "wire_format.h"
+
+namespace
+{
+    const char *JSON_TYPE = "application/json";
+    const char *MSGPACK_TYPE = "application/msgpack";
+
+    uint8_t body[WIRE_MAX_BODY];
+    size_t bodyLength = 0;
+    bool bodyTruncated = false;
+}
+
+const char *wireContentType(WireFormat format)
+{
+    return format == WIRE_MSGPACK ? MSGPACK_TYPE : JSON_TYPE;
+}
+
+WireFormat wireFormatFromContentType(const String &contentType)
+{
+    // Also accept the unregistered "application/x-msgpack" some clients send.
+    return contentType.indexOf("msgpack") >= 0 ? WIRE_MSGPACK : WIRE_JSON;
+}
+
+bool wireAccepts(const String &acceptHeader, WireFormat format)
+{
+    if (format == WIRE_JSON)
+    {
+        return true; // always understood
+    }
+    return acceptHeader.indexOf("msgpack") >= 0;
+}
+
+void wireCaptureBody(HTTPRaw &raw)
+{
+    switch (raw.status)
+    {
+    case RAW_START:
+        bodyLength = 0;
+        bodyTruncated = false;
+        break;
+    case RAW_WRITE:
+    {
+        size_t room = WIRE_MAX_BODY - bodyLength;
+        size_t n = raw.currentSize < room ? raw.currentSize : room;
+        memcpy(body + bodyLength, raw.buf, n);
+        bodyLength += n;
+        bodyTruncated |= n < raw.currentSize;
+        break;
+    }
+    case RAW_END:
+    case RAW_ABORTED:
+        break;
+    }
+}
+
+size_t wireBodyLength()
+{
+    return bodyLength;
+}
+
+DeserializationError wireDecodeRequest(WebServer &server, JsonDocument &doc)
+{
+    if (bodyTruncated)
+    {
+        return DeserializationError::NoMemory;
+    }
+    return wireDecode(doc, body, bodyLength, wireFormatFromContentType(server.header("Content-Type")));
+}
+
+void wireRespond(WebServer &server, int code, const JsonDocument &doc)
+{
+    uint8_t reply[WIRE_MAX_BODY];
+    wireRespond(server, code, doc, reply, sizeof(reply));
+}
+
+void wireRespond(WebServer &server, int code, const JsonDocument &doc, uint8_t *buffer, size_t capacity)
+{
+    WireFormat format = wireAccepts(server.header("Accept"), WIRE_MSGPACK) ? WIRE_MSGPACK : WIRE_JSON;
+    size_t length = wireEncode(doc, buffer, capacity, format);
+    server.send_P(code, wireContentType(format), (const char *)buffer, length); // length-bounded: binary-safe
+}
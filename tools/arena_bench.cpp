@@ -0,0 +1,165 @@
+// Host benchmark: BumpArena vs malloc/free for the allocation pattern of
+// each request type, plus the arena's peak usage per request.
+//
+//     g++ -O2 -std=c++17 -Iinclude tools/arena_bench.cpp -o arena_bench && ./arena_bench
+//
+// The patterns model what ArduinoJson 7 does on the ESP32 (4-byte
+// pointers, 8-byte slots): one pool list, a slot pool of 16 slots that is
+// followed by another when it fills up, and one string node per copied key
+// or string value. Strings parsed from a body are first built in a
+// 31-byte buffer that is then shrunk with reallocate(). Serialized
+// documents copy only the char* values; literal keys are stored by pointer.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "bump_arena.h"
+
+namespace
+{
+    const size_t ARENA_SIZE = 4096; // REQUEST_ARENA_SIZE in request_arena.h
+    const size_t POOL_LIST_BYTES = 4 * 4;
+    const size_t SLOT_BYTES = 8;
+    const size_t SLOTS_PER_POOL = 16;
+    const size_t STRING_BUILDER_BYTES = 31;
+    const size_t STRING_NODE_HEADER = 8;
+
+    struct Op
+    {
+        enum Kind
+        {
+            ALLOCATE,
+            SHRINK_LAST, // reallocate the previous block to `size`
+        } kind;
+        size_t size;
+    };
+
+    struct Pattern
+    {
+        const char *tag;
+        std::vector<Op> ops;
+    };
+
+    void addDocument(std::vector<Op> &ops, size_t slots)
+    {
+        ops.push_back({Op::ALLOCATE, POOL_LIST_BYTES});
+        for (size_t pools = (slots + SLOTS_PER_POOL - 1) / SLOTS_PER_POOL; pools > 0; pools--)
+        {
+            ops.push_back({Op::ALLOCATE, SLOTS_PER_POOL * SLOT_BYTES});
+        }
+    }
+
+    void addParsedString(std::vector<Op> &ops, size_t length)
+    {
+        ops.push_back({Op::ALLOCATE, STRING_BUILDER_BYTES});
+        ops.push_back({Op::SHRINK_LAST, STRING_NODE_HEADER + length + 1});
+    }
+
+    std::vector<Pattern> buildPatterns()
+    {
+        std::vector<Pattern> patterns;
+
+        // {"user_id": 42, "username": "daniel", "volume": 20, "sound": 3}
+        Pattern login = {"esp-login", {}};
+        addDocument(login.ops, 5);
+        const size_t loginStrings[] = {7, 8, 6, 6, 5};
+        for (size_t length : loginStrings)
+        {
+            addParsedString(login.ops, length);
+        }
+        patterns.push_back(login);
+
+        // {"volume": 20}
+        Pattern volume = {"set-volume", {}};
+        addDocument(volume.ops, 2);
+        addParsedString(volume.ops, 6);
+        patterns.push_back(volume);
+
+        // Active player plus 8 queued, each {"user_id", "username"}
+        Pattern queue = {"queue", {}};
+        addDocument(queue.ops, 4 + 9 * 3);
+        for (int player = 0; player < 9; player++)
+        {
+            queue.ops.push_back({Op::ALLOCATE, STRING_NODE_HEADER + 24 + 1});
+        }
+        patterns.push_back(queue);
+
+        // {"user_id", "score", "seed", "mode", "gen", "device_id": "24A1600B1C2D"}
+        Pattern score = {"submit-score", {}};
+        addDocument(score.ops, 7);
+        score.ops.push_back({Op::ALLOCATE, STRING_NODE_HEADER + 12 + 1});
+        patterns.push_back(score);
+
+        return patterns;
+    }
+
+    template <class Run>
+    double nanosPerRequest(Run run, int iterations)
+    {
+        auto startedAt = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            run();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - startedAt;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+}
+
+int main()
+{
+    const int iterations = 2000000;
+    alignas(max_align_t) static uint8_t memory[ARENA_SIZE];
+    BumpArena arena(memory, sizeof(memory));
+    std::vector<void *> blocks;
+    blocks.reserve(64);
+    void *volatile sink = nullptr;
+
+    printf("%-14s %5s %12s %12s %8s %10s\n", "request", "allocs", "malloc ns", "arena ns", "speedup", "peak bytes");
+    for (const Pattern &pattern : buildPatterns())
+    {
+        double heapNs = nanosPerRequest(
+            [&]() {
+                blocks.clear();
+                for (const Op &op : pattern.ops)
+                {
+                    if (op.kind == Op::ALLOCATE)
+                    {
+                        blocks.push_back(malloc(op.size));
+                    }
+                    else
+                    {
+                        blocks.back() = realloc(blocks.back(), op.size);
+                    }
+                }
+                sink = blocks.back();
+                for (void *block : blocks)
+                {
+                    free(block);
+                }
+            },
+            iterations);
+
+        arena.reset();
+        arena.resetPeak();
+        double arenaNs = nanosPerRequest(
+            [&]() {
+                void *last = nullptr;
+                for (const Op &op : pattern.ops)
+                {
+                    last = op.kind == Op::ALLOCATE ? arena.allocate(op.size) : arena.reallocate(last, op.size);
+                }
+                sink = last;
+                arena.reset();
+            },
+            iterations);
+
+        printf("%-14s %5zu %12.1f %12.1f %7.1fx %10zu\n", pattern.tag, pattern.ops.size(), heapNs, arenaNs,
+               heapNs / arenaNs, arena.peak());
+    }
+    (void)sink;
+    printf("\narena capacity %zu bytes, %u failed allocations\n", ARENA_SIZE, arena.failures());
+    return 0;
+}
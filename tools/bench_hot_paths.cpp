@@ -0,0 +1,426 @@
+// Google Benchmark suite for the game's hot paths, built on the host.
+//
+//     g++ -O2 -std=c++17 -Iinclude tools/bench_hot_paths.cpp src/difficulty.cpp -lbenchmark -lpthread -o bench
+//     ./bench --benchmark_repetitions=5 --benchmark_out=bench.json --benchmark_out_format=json
+//     python3 scripts/bench_compare.py tools/bench_baseline.json bench.json
+//
+// bench_compare.py flags every benchmark that got slower than the committed
+// baseline by more than its threshold (15% by default) and exits non-zero.
+// Medians of the repetitions are compared; single runs of the nanosecond
+// benchmarks vary by 10% or more on their own. Refresh the baseline (add
+// --update to the compare command) on the machine that runs the comparison.
+//
+// Covered: DFPlayer frame encoding, drawing a step with PCG32 and with
+// random(), press handling and a whole round in each game mode, the LCD
+// score line, the difficulty JSON, a full /metrics render, a deferred log
+// call against formatting the same line, and whole rounds / whole games at
+// sequence lengths 10 to 10,000 with both sequence storages and the
+// std::vector<int> they replaced. The round benchmarks also report the
+// storage's bytes at each length as the "bytes" counter.
+// Everything here is the firmware's own code; the Arduino-bound parts
+// (debounce delays, UART, LCD I2C, ArduinoJson) are not available on the
+// host.
+
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "dfplayer.h"
+#include "fixed_string.h"
+#include "game_core.h"
+#include "log_messages.h"
+#include "metrics_registry.h"
+#include "mpsc_ring.h"
+
+namespace
+{
+    const size_t MAX_STEPS = 10000;
+
+    void BM_DfplayerFrame(benchmark::State &state)
+    {
+        uint8_t frame[DFPLAYER_FRAME_SIZE];
+        int track = 0;
+        for (auto _ : state)
+        {
+            dfplayerPlayInFolder(frame, 3, track++ % 5 + 1);
+            benchmark::DoNotOptimize(frame);
+        }
+    }
+    BENCHMARK(BM_DfplayerFrame);
+
+    // Pearson's chi-square of button counts against a uniform 1/5 each; with
+    // 4 degrees of freedom anything under 13.3 passes at the 1% level.
+    double chiSquare(const int64_t (&counts)[5])
+    {
+        int64_t total = 0;
+        for (int64_t count : counts)
+        {
+            total += count;
+        }
+        double expected = total / 5.0;
+        double chi2 = 0;
+        for (int64_t count : counts)
+        {
+            chi2 += (count - expected) * (count - expected) / expected;
+        }
+        return chi2;
+    }
+
+    // Drawing the next step: PCG32's unbiased bounded() against random() % 5,
+    // the libc generator Arduino's random(0, 5) falls back to once seeded
+    // (on the device unseeded random() reads the hardware RNG instead, which
+    // no seed can replay). The "chi2" counter checks all draws for bias.
+    void BM_StepPcg32(benchmark::State &state)
+    {
+        Pcg32 rng(2654435769u);
+        int64_t counts[5] = {};
+        for (auto _ : state)
+        {
+            uint32_t step = rng.bounded(5);
+            benchmark::DoNotOptimize(step);
+            counts[step]++;
+        }
+        state.counters["chi2"] = chiSquare(counts);
+    }
+    BENCHMARK(BM_StepPcg32);
+
+    void BM_StepRandom(benchmark::State &state)
+    {
+        srandom(2654435769u);
+        int64_t counts[5] = {};
+        for (auto _ : state)
+        {
+            long step = random() % 5;
+            benchmark::DoNotOptimize(step);
+            counts[step]++;
+        }
+        state.counters["chi2"] = chiSquare(counts);
+    }
+    BENCHMARK(BM_StepRandom);
+
+    // One correct press: order lookup, sequence read, difficulty statistics.
+    template <class Mode>
+    void BM_PressEvent(benchmark::State &state)
+    {
+        static PackedSequence<MAX_STEPS> sequence;
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        GameCore<Mode, PackedSequence<MAX_STEPS>> core(sequence, rng, difficulty, MAX_STEPS);
+        core.start(1);
+        while (core.length() < 100)
+        {
+            core.extend();
+        }
+        size_t index = 0;
+        for (auto _ : state)
+        {
+            bool correct = core.press(index, core.expected(index), 400);
+            benchmark::DoNotOptimize(correct);
+            index = (index + 1) % core.length();
+        }
+    }
+    BENCHMARK_TEMPLATE(BM_PressEvent, ClassicMode);
+    BENCHMARK_TEMPLATE(BM_PressEvent, ReverseMode);
+    BENCHMARK_TEMPLATE(BM_PressEvent, TimeAttackMode);
+    BENCHMARK_TEMPLATE(BM_PressEvent, DoubleStepMode);
+
+    // One round of each mode as game_flow.h's player turn runs it: the
+    // mode's extension, then per step the timing rule, the order lookup and
+    // the press, then the round's score. The game restarts whenever the
+    // sequence reaches 100 steps. Items/s = presses/s.
+    template <class Mode>
+    void BM_ModeRound(benchmark::State &state)
+    {
+        static PackedSequence<MAX_STEPS> sequence;
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        GameCore<Mode, PackedSequence<MAX_STEPS>> core(sequence, rng, difficulty, MAX_STEPS);
+        core.start(1);
+        unsigned long now = 0;
+        int64_t presses = 0;
+        for (auto _ : state)
+        {
+            if (core.length() >= 100)
+            {
+                core.start(1);
+                difficulty.reset();
+            }
+            core.extend();
+            for (size_t i = 0; i < core.length(); i++)
+            {
+                now += 400;
+                bool expired = core.expired(now, now - 1000, now - 400);
+                bool correct = core.press(i, core.expected(i), 400);
+                benchmark::DoNotOptimize(expired);
+                benchmark::DoNotOptimize(correct);
+            }
+            presses += core.length();
+            int score = core.roundCleared();
+            benchmark::DoNotOptimize(score);
+        }
+        state.SetItemsProcessed(presses);
+    }
+    BENCHMARK_TEMPLATE(BM_ModeRound, ClassicMode);
+    BENCHMARK_TEMPLATE(BM_ModeRound, ReverseMode);
+    BENCHMARK_TEMPLATE(BM_ModeRound, TimeAttackMode);
+    BENCHMARK_TEMPLATE(BM_ModeRound, DoubleStepMode);
+
+    // "Score: N" for the LCD, as built now and as the old String concatenation did.
+    void BM_ScoreLineFixed(benchmark::State &state)
+    {
+        int score = 0;
+        for (auto _ : state)
+        {
+            FixedString<16> line("Score: ");
+            line += score;
+            benchmark::DoNotOptimize(line.c_str());
+            score += 10;
+        }
+    }
+    BENCHMARK(BM_ScoreLineFixed);
+
+    void BM_ScoreLineHeap(benchmark::State &state)
+    {
+        int score = 0;
+        for (auto _ : state)
+        {
+            std::string line = "Score: " + std::to_string(score);
+            benchmark::DoNotOptimize(line.c_str());
+            score += 10;
+        }
+    }
+    BENCHMARK(BM_ScoreLineHeap);
+
+    // Built after every game and on each /difficulty request.
+    void BM_DifficultyJson(benchmark::State &state)
+    {
+        DifficultyEngine difficulty;
+        for (int i = 0; i < 50; i++)
+        {
+            difficulty.recordPress(350 + i, i % 7 != 0);
+            difficulty.recordRound(i % 5 != 0);
+        }
+        char json[DIFFICULTY_JSON_MAX];
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(difficulty.toJson(json, sizeof(json)));
+        }
+    }
+    BENCHMARK(BM_DifficultyJson);
+
+    // One /metrics scrape into a sink that only counts, i.e. the rendering
+    // cost without the TCP writes. Bytes/s = exposition text produced.
+    struct CountingSink
+    {
+        size_t bytes = 0;
+        void write(const char *data, size_t length)
+        {
+            benchmark::DoNotOptimize(data);
+            bytes += length;
+        }
+    };
+
+    void BM_MetricsRender(benchmark::State &state)
+    {
+        static MetricsRegistry registry = {};
+        // The routes the firmware registers through metricsOn()
+        static const char *const ROUTES[] = {
+            "/metrics", "/settings", "/boot", "/replays", "/replay", "/arena", "/memory", "/profile",
+            "/trace", "/events", "/set-volume", "/", "/esp-login", "/esp-logout", "/queue", "/difficulty",
+        };
+        for (const char *route : ROUTES)
+        {
+            metricsAddRoute(registry, route);
+        }
+        Pcg32 rng(3);
+        for (int i = 0; i < 500; i++)
+        {
+            registry.rounds.observe(METRICS_ROUND_BOUNDS, 1 + rng.bounded(40));
+            registry.scores.observe(METRICS_SCORE_BOUNDS, rng.bounded(1200));
+            registry.buttonPresses[rng.bounded(METRICS_BUTTONS)] += 20;
+            int route = rng.bounded(registry.routeCount + 1); // the last one stands for "other"
+            int slot = route < registry.routeCount ? route : METRICS_ROUTE_OTHER;
+            registry.requestLatency[slot].observe(METRICS_LATENCY_BOUNDS_US, rng.bounded(3000000));
+        }
+        MetricsGauges gauges = {2, 5, 142000, 118000, 86400123456ull, 1850, 14600, 0, 3500000000ull, 61000000ull, 23000, 4, 310, 4100};
+        CountingSink sink;
+        for (auto _ : state)
+        {
+            PrometheusWriter<CountingSink> writer(sink);
+            renderMetrics(writer, registry, gauges);
+        }
+        state.SetBytesProcessed(sink.bytes);
+    }
+    BENCHMARK(BM_MetricsRender);
+
+    // What a logDeferred<LOG_UPLOAD_FAILED>(...) call costs the game loop
+    // (record fill and ring push; the device also reads its timer), against
+    // formatting the same line, which the drain task now does instead.
+    void BM_LogPush(benchmark::State &state)
+    {
+        static MpscRing<LogRecord, 128> ring;
+        LogRecord record = {};
+        uint32_t now = 0;
+        int pushed = 0;
+        for (auto _ : state)
+        {
+            const uint32_t words[LOG_MAX_ARGS + 1] = {logWord(-1), logWord(1234ul), logWord(7u)};
+            record.atUs = now++;
+            record.id = LOG_UPLOAD_FAILED;
+            record.argc = 3;
+            memcpy(record.args, words, sizeof(record.args));
+            benchmark::DoNotOptimize(ring.push(record));
+            if (++pushed == 64)
+            {
+                state.PauseTiming();
+                while (ring.pop(record))
+                {
+                }
+                pushed = 0;
+                state.ResumeTiming();
+            }
+        }
+    }
+    BENCHMARK(BM_LogPush);
+
+    void BM_LogFormat(benchmark::State &state)
+    {
+        LogRecord record = {0, LOG_UPLOAD_FAILED, 3, 0, {(uint32_t)-1, 1234, 7}};
+        char line[160];
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(logFormat(line, sizeof(line), record));
+        }
+    }
+    BENCHMARK(BM_LogFormat);
+
+    // The sequence as it was stored before PackedSequence: one int per
+    // step in a growing std::vector, kept here as the comparison point.
+    struct VectorSequence
+    {
+        std::vector<int> steps;
+
+        size_t size() const { return steps.size(); }
+        uint8_t operator[](size_t index) const { return steps[index]; }
+        std::vector<int>::const_iterator begin() const { return steps.begin(); }
+        std::vector<int>::const_iterator end() const { return steps.end(); }
+    };
+
+    void resetSequence(VectorSequence &sequence, uint32_t)
+    {
+        sequence.steps.clear();
+    }
+
+    void appendStep(VectorSequence &sequence, Pcg32 &rng)
+    {
+        sequence.steps.push_back(rng.bounded(5));
+    }
+
+    // Bytes the storage occupies, heap included.
+    template <class Sequence>
+    size_t storageBytes(const Sequence &sequence)
+    {
+        return sizeof(sequence);
+    }
+
+    size_t storageBytes(const VectorSequence &sequence)
+    {
+        return sizeof(sequence) + sequence.steps.capacity() * sizeof(int);
+    }
+
+    // One full round at sequence length N: Simon's playback walk plus N
+    // correct presses and the round close. Items/s = presses/s.
+    template <class Sequence>
+    void BM_Round(benchmark::State &state)
+    {
+        static Sequence sequence;
+        const size_t length = state.range(0);
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        GameCore<ClassicMode, Sequence> core(sequence, rng, difficulty, length);
+        core.start(7);
+        while (core.extend() > 0)
+        {
+        }
+        for (auto _ : state)
+        {
+            unsigned checksum = 0;
+            for (uint8_t step : sequence)
+            {
+                checksum += step;
+            }
+            for (size_t i = 0; i < length; i++)
+            {
+                core.press(i, core.expected(i), 400);
+            }
+            checksum += core.roundCleared();
+            benchmark::DoNotOptimize(checksum);
+        }
+        state.SetItemsProcessed(state.iterations() * length);
+        state.counters["bytes"] = storageBytes(sequence);
+    }
+    BENCHMARK_TEMPLATE(BM_Round, PackedSequence<MAX_STEPS>)->RangeMultiplier(10)->Range(10, 10000);
+    BENCHMARK_TEMPLATE(BM_Round, SeededSequence)->RangeMultiplier(10)->Range(10, 10000);
+    BENCHMARK_TEMPLATE(BM_Round, VectorSequence)->RangeMultiplier(10)->Range(10, 10000);
+
+    // Simon's playback walk alone at length N, without the presses that
+    // dominate BM_Round: the iteration cost of each storage.
+    template <class Sequence>
+    void BM_Playback(benchmark::State &state)
+    {
+        static Sequence sequence;
+        const size_t length = state.range(0);
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        GameCore<ClassicMode, Sequence> core(sequence, rng, difficulty, length);
+        core.start(7);
+        while (core.extend() > 0)
+        {
+        }
+        for (auto _ : state)
+        {
+            unsigned checksum = 0;
+            for (uint8_t step : sequence)
+            {
+                checksum += step;
+            }
+            benchmark::DoNotOptimize(checksum);
+        }
+        state.SetItemsProcessed(state.iterations() * length);
+    }
+    BENCHMARK_TEMPLATE(BM_Playback, PackedSequence<MAX_STEPS>)->RangeMultiplier(10)->Range(10, 10000);
+    BENCHMARK_TEMPLATE(BM_Playback, SeededSequence)->RangeMultiplier(10)->Range(10, 10000);
+    BENCHMARK_TEMPLATE(BM_Playback, VectorSequence)->RangeMultiplier(10)->Range(10, 10000);
+
+    // A whole perfect game from an empty sequence up to length N.
+    void BM_Game(benchmark::State &state)
+    {
+        static PackedSequence<MAX_STEPS> sequence;
+        const size_t length = state.range(0);
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        int64_t presses = 0;
+        for (auto _ : state)
+        {
+            GameCore<ClassicMode, PackedSequence<MAX_STEPS>> core(sequence, rng, difficulty, length);
+            difficulty.reset();
+            core.start(7);
+            int score = 0;
+            while (core.extend() > 0)
+            {
+                for (size_t i = 0; i < core.length(); i++)
+                {
+                    core.press(i, core.expected(i), 400);
+                }
+                presses += core.length();
+                score += core.roundCleared();
+            }
+            benchmark::DoNotOptimize(score);
+        }
+        state.SetItemsProcessed(presses);
+    }
+    BENCHMARK(BM_Game)->RangeMultiplier(10)->Range(10, 1000);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "game_flow.h"
+#include "pcg32.h"
+
+// Scripted players for the host tools, played through game_flow.h on a
+// VirtualBoard (virtual_board.h).
+//
+// Every bot answers one press at a time: given the step it should press and
+// its position in the sequence, it returns the button it presses (or
+// NO_PRESS to stay silent) and how long it took to react. Reaction times
+// are ex-Gaussian (normal + exponential tail), the usual fit for human
+// choice reaction times. The board passes the game's hooks on to the bot;
+// PlayerEvents ignores them for bots that don't care.
+
+const uint8_t NO_PRESS = 0xff;
+
+struct PlayerEvents
+{
+    template <class Core>
+    void onRoundStart(const Core &, int) {}
+    void onPress(int, unsigned long, bool) {}
+    void onRoundCleared(int) {}
+    void onGameEnd(GameEnd) {}
+};
+
+struct ReactionModel
+{
+    float muMs;    // normal component mean
+    float sigmaMs; // normal component spread
+    float tauMs;   // exponential tail (hesitation)
+};
+
+// Typical adult 5-choice reaction time with a small floor.
+const ReactionModel DEFAULT_REACTION = {380.0f, 60.0f, 120.0f};
+
+// Uniform float in (0, 1], never 0 so logf() is safe.
+inline float unitFloat(Pcg32 &rng)
+{
+    return ((rng.next() >> 8) + 1) * (1.0f / 16777216.0f);
+}
+
+inline unsigned long sampleReaction(const ReactionModel &model, Pcg32 &rng)
+{
+    // Box-Muller for the normal part, inverse CDF for the exponential tail.
+    float u1 = unitFloat(rng);
+    float u2 = unitFloat(rng);
+    float normal = sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+    float tail = -model.tauMs * logf(unitFloat(rng));
+    float ms = model.muMs + model.sigmaMs * normal + tail;
+    return ms < 100.0f ? 100 : (unsigned long)ms;
+}
+
+inline uint8_t wrongButton(uint8_t expected, Pcg32 &rng)
+{
+    return (uint8_t)((expected + 1 + rng.bounded(4)) % 5);
+}
+
+// Never forgets, never slips.
+struct PerfectBot : PlayerEvents
+{
+    ReactionModel reaction = DEFAULT_REACTION;
+
+    void startGame(Pcg32 &) {}
+
+    uint8_t press(size_t, uint8_t expected, Pcg32 &rng, unsigned long &reactionMs)
+    {
+        reactionMs = sampleReaction(reaction, rng);
+        return expected;
+    }
+};
+
+// Remembers everything but slips on a fixed fraction of presses.
+struct ErrorRateBot : PlayerEvents
+{
+    ReactionModel reaction = DEFAULT_REACTION;
+    float errorRate = 0.02f;
+
+    void startGame(Pcg32 &) {}
+
+    uint8_t press(size_t, uint8_t expected, Pcg32 &rng, unsigned long &reactionMs)
+    {
+        reactionMs = sampleReaction(reaction, rng);
+        return unitFloat(rng) <= errorRate ? wrongButton(expected, rng) : expected;
+    }
+};
+
+// Holds a limited number of steps (span drawn per game, Miller's 7 +- 2).
+// Steps beyond the span are recalled with spillRecall probability and take
+// longer, since the player is reconstructing rather than replaying.
+struct MemorySpanBot : PlayerEvents
+{
+    ReactionModel reaction = DEFAULT_REACTION;
+    float spanMean = 7.0f;
+    float spanStddev = 2.0f;
+    float spillRecall = 0.6f;
+    float spillSlowdown = 1.5f;
+
+    void startGame(Pcg32 &rng)
+    {
+        float u1 = unitFloat(rng);
+        float u2 = unitFloat(rng);
+        float span = spanMean + spanStddev * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+        span_ = span < 1.0f ? 1 : (size_t)(span + 0.5f);
+    }
+
+    uint8_t press(size_t index, uint8_t expected, Pcg32 &rng, unsigned long &reactionMs)
+    {
+        reactionMs = sampleReaction(reaction, rng);
+        if (index < span_)
+        {
+            return expected;
+        }
+        reactionMs = (unsigned long)(reactionMs * spillSlowdown);
+        return unitFloat(rng) <= spillRecall ? expected : wrongButton(expected, rng);
+    }
+
+private:
+    size_t span_ = 7;
+};
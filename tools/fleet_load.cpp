@@ -0,0 +1,730 @@
+// Fleet load generator: N simulated cabinets playing games and uploading
+// scores to a local stand-in for the FastAPI backend, stepping N up to
+// venue scale and beyond.
+//
+//     g++ -O2 -std=c++17 -Iinclude -Itools tools/fleet_load.cpp src/difficulty.cpp -pthread -o fleet_load
+//     ./fleet_load --devices 10,100,1000,3000 --seconds 20 --speed 60
+//
+// Options:
+//     --devices N,N,...   fleet sizes to run, one step each (default 10,100,1000)
+//     --seconds S         length of each step (default 15)
+//     --speed X           virtual game time per real second (default 60: a
+//                         three-minute game takes three seconds, so each
+//                         cabinet submits about X times as often as at a
+//                         venue). 1 replays venue pace.
+//     --mode M            classic | reverse | time | double
+//     --bot B             perfect | error:<rate> | span:<mean>
+//     --backend HOST:PORT submit to a running backend instead of the stand-in
+//     --workers N         stand-in request workers (default 4)
+//     --service-ms N      stand-in time per submission, e.g. a DB commit (default 5)
+//     --backlog N         stand-in listen backlog (default 2048, uvicorn's)
+//     --seed S
+//
+// Each cabinet is a thread that plays a game through the firmware's flow
+// and rules (game_flow.h, game_core.h) on a VirtualBoard with a scripted
+// bot, sleeps for the game's virtual duration divided by --speed, and then
+// uploads the score the way submitScore() does. That means a fresh TCP
+// connection, the same headers and JSON body, the device's 2 s connect
+// and 3 s response timeouts, and Connection: close. Start times are
+// staggered by a random fraction of the first game.
+//
+// The stand-in accepts POST /submit-score on loopback, checks the body for
+// the device's fields, holds each request for --service-ms on one of
+// --workers threads and answers 200 like the backend. Past its capacity
+// (workers * 1000 / service-ms per second) requests queue in the accept
+// backlog and the device-side latency shows it.
+//
+// Per step the report gives:
+// - submissions/s that succeeded within the step
+// - device-side latency percentiles (connect to response, as the device
+//   measures it)
+// - failures by kind: connect refused or timed out, response timed out,
+//   HTTP errors
+// /esp-login is pushed by the backend to the cabinet's own WebServer, which
+// doesn't exist on the host, so logins aren't generated; each game starts
+// with the next bot.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bot_players.h"
+#include "game_core.h"
+#include "virtual_board.h"
+
+namespace
+{
+    const int CONNECT_TIMEOUT_MS = 2000;  // backendConnectTimeoutMs in main.cpp
+    const int RESPONSE_TIMEOUT_MS = 3000; // backendResponseTimeoutMs in main.cpp
+    const size_t MAX_STEPS = 500;
+    const unsigned long POLL_MS = 10;
+    const size_t DEVICE_STACK = 256 * 1024;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options
+    {
+        std::vector<int> devices = {10, 100, 1000};
+        double seconds = 15;
+        double speed = 60;
+        GameModeId mode = MODE_CLASSIC;
+        char bot[32] = "error:0.02";
+        char backend[64] = "";
+        int workers = 4;
+        int serviceMs = 5;
+        int backlog = 2048;
+        uint32_t seed = 1;
+    };
+
+    enum Outcome
+    {
+        OUTCOME_OK,
+        OUTCOME_CONNECT_REFUSED,
+        OUTCOME_CONNECT_TIMEOUT,
+        OUTCOME_RESPONSE_TIMEOUT,
+        OUTCOME_HTTP_ERROR,
+        OUTCOME_SOCKET_ERROR,
+        OUTCOME_COUNT,
+    };
+    const char *const OUTCOME_NAMES[OUTCOME_COUNT] = {"ok", "connect refused", "connect timeout",
+                                                      "response timeout", "http error", "socket error"};
+
+    struct Submission
+    {
+        Outcome outcome;
+        uint32_t latencyUs;
+        bool inWindow; // completed before the step ended
+    };
+
+    // ---- Backend stand-in -------------------------------------------------
+
+    class StandIn
+    {
+    public:
+        bool start(const Options &options)
+        {
+            serviceMs_ = options.serviceMs;
+            listener_ = socket(AF_INET, SOCK_STREAM, 0);
+            int one = 1;
+            setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (bind(listener_, (sockaddr *)&address, sizeof(address)) != 0 ||
+                listen(listener_, options.backlog) != 0 || getsockname(listener_, (sockaddr *)&address, &length) != 0)
+            {
+                return false;
+            }
+            port_ = ntohs(address.sin_port);
+            acceptor_ = std::thread(&StandIn::acceptLoop, this);
+            for (int i = 0; i < options.workers; i++)
+            {
+                workers_.emplace_back(&StandIn::work, this);
+            }
+            return true;
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                stopping_ = true;
+            }
+            ready_.notify_all();
+            shutdown(listener_, SHUT_RDWR);
+            close(listener_);
+            acceptor_.join();
+            for (std::thread &worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        int port() const { return port_; }
+        unsigned long long served() const { return served_; }
+        unsigned long long rejected() const { return rejected_; }
+
+    private:
+        void acceptLoop()
+        {
+            for (;;)
+            {
+                int fd = accept(listener_, nullptr, nullptr);
+                if (fd < 0)
+                {
+                    if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE)
+                    {
+                        continue;
+                    }
+                    return; // listener closed
+                }
+                std::lock_guard<std::mutex> guard(lock_);
+                pending_.push_back(fd);
+                ready_.notify_one();
+            }
+        }
+
+        void work()
+        {
+            for (;;)
+            {
+                int fd;
+                {
+                    std::unique_lock<std::mutex> guard(lock_);
+                    ready_.wait(guard, [this]() { return stopping_ || !pending_.empty(); });
+                    if (pending_.empty())
+                    {
+                        return;
+                    }
+                    fd = pending_.front();
+                    pending_.pop_front();
+                }
+                serve(fd);
+                close(fd);
+            }
+        }
+
+        void serve(int fd)
+        {
+            char request[2048];
+            size_t length = 0;
+            size_t bodyAt = 0;
+            size_t contentLength = 0;
+            for (;;)
+            {
+                ssize_t n = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+                if (n <= 0)
+                {
+                    return;
+                }
+                length += n;
+                request[length] = '\0';
+                if (!bodyAt)
+                {
+                    const char *end = strstr(request, "\r\n\r\n");
+                    if (!end)
+                    {
+                        continue;
+                    }
+                    bodyAt = end + 4 - request;
+                    const char *header = strcasestr(request, "Content-Length:");
+                    contentLength = header ? strtoul(header + 15, nullptr, 10) : 0;
+                }
+                if (length >= bodyAt + contentLength || length == sizeof(request) - 1)
+                {
+                    break;
+                }
+            }
+
+            const char *body = request + bodyAt;
+            bool valid = strncmp(request, "POST /submit-score ", 19) == 0 && strstr(body, "\"user_id\"") &&
+                         strstr(body, "\"score\"") && strstr(body, "\"device_id\"");
+            if (valid && serviceMs_ > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(serviceMs_));
+            }
+            const char *reply = valid ? "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 32\r\n"
+                                        "Connection: close\r\n\r\n{\"message\": \"Score submitted.\"}\n"
+                                      : "HTTP/1.1 422 Unprocessable Entity\r\nContent-Length: 0\r\n"
+                                        "Connection: close\r\n\r\n";
+            send(fd, reply, strlen(reply), MSG_NOSIGNAL);
+            (valid ? served_ : rejected_)++;
+        }
+
+        int listener_ = -1;
+        int port_ = 0;
+        int serviceMs_ = 0;
+        std::thread acceptor_;
+        std::vector<std::thread> workers_;
+        std::mutex lock_;
+        std::condition_variable ready_;
+        std::deque<int> pending_;
+        bool stopping_ = false;
+        std::atomic<unsigned long long> served_{0};
+        std::atomic<unsigned long long> rejected_{0};
+    };
+
+    // ---- Device side ------------------------------------------------------
+
+    bool waitFor(int fd, short events, int timeoutMs)
+    {
+        pollfd p = {fd, events, 0};
+        return poll(&p, 1, timeoutMs) == 1;
+    }
+
+    int remainingMs(Clock::time_point deadline)
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        return left > 0 ? (int)left : 0;
+    }
+
+    // submitScore(): connect, POST, read the status line, close.
+    Outcome upload(const sockaddr_in &backend, const char *host, long userId, int score, uint32_t seed,
+                   GameModeId mode, const char *deviceId)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0)
+        {
+            return OUTCOME_SOCKET_ERROR;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, (const sockaddr *)&backend, sizeof(backend)) != 0 && errno != EINPROGRESS)
+        {
+            Outcome outcome = errno == ECONNREFUSED ? OUTCOME_CONNECT_REFUSED : OUTCOME_SOCKET_ERROR;
+            close(fd);
+            return outcome;
+        }
+        if (!waitFor(fd, POLLOUT, CONNECT_TIMEOUT_MS))
+        {
+            close(fd);
+            return OUTCOME_CONNECT_TIMEOUT;
+        }
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+        if (error)
+        {
+            close(fd);
+            return error == ECONNREFUSED ? OUTCOME_CONNECT_REFUSED : OUTCOME_SOCKET_ERROR;
+        }
+
+        char body[128];
+        int bodyLength = snprintf(body, sizeof(body),
+                                  "{\"user_id\":%ld,\"score\":%d,\"seed\":%u,\"mode\":%d,\"gen\":%d,\"device_id\":\"%s\"}",
+                                  userId, score, (unsigned)seed, (int)mode, (int)SEQUENCE_GEN_PCG32, deviceId);
+        char request[512];
+        int length = snprintf(request, sizeof(request),
+                              "POST /submit-score HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP32HTTPClient\r\n"
+                              "Connection: close\r\nAccept: application/msgpack, application/json\r\n"
+                              "Content-Type: application/json\r\nContent-Length: %d\r\n\r\n%s",
+                              host, bodyLength, body);
+        if (send(fd, request, length, MSG_NOSIGNAL) != length)
+        {
+            close(fd);
+            return OUTCOME_SOCKET_ERROR;
+        }
+
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(RESPONSE_TIMEOUT_MS);
+        char response[256];
+        size_t received = 0;
+        while (received < 12) // "HTTP/1.1 200"
+        {
+            if (!waitFor(fd, POLLIN, remainingMs(deadline)))
+            {
+                close(fd);
+                return OUTCOME_RESPONSE_TIMEOUT;
+            }
+            ssize_t n = recv(fd, response + received, sizeof(response) - 1 - received, 0);
+            if (n <= 0)
+            {
+                close(fd);
+                return OUTCOME_SOCKET_ERROR;
+            }
+            received += n;
+        }
+        response[received] = '\0';
+        close(fd);
+        return strncmp(response + 9, "200", 3) == 0 ? OUTCOME_OK : OUTCOME_HTTP_ERROR;
+    }
+
+    struct Step
+    {
+        const Options *options;
+        sockaddr_in backend;
+        char host[64];
+        std::atomic<bool> stop{false};
+        Clock::time_point windowEnd;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::mutex resultsLock;
+        std::vector<Submission> results;
+        std::atomic<unsigned long long> games{0};
+    };
+
+    struct Device
+    {
+        Step *step;
+        int index;
+    };
+
+    template <class Mode, class Bot>
+    int playGame(Bot &bot, Pcg32 &botRng, DifficultyEngine &difficulty, uint32_t seed, unsigned long &durationMs)
+    {
+        static thread_local PackedSequence<MAX_STEPS> sequence;
+        Pcg32 rng;
+        GameCore<Mode, PackedSequence<MAX_STEPS>> core(sequence, rng, difficulty, MAX_STEPS);
+        core.start(seed);
+        bot.startGame(botRng);
+        VirtualBoard<GameCore<Mode, PackedSequence<MAX_STEPS>>, Bot> board(core, bot, botRng, 80, POLL_MS);
+        int score = 0;
+        playRounds(board, core, score);
+        durationMs = board.millis();
+        return score;
+    }
+
+    template <class Bot>
+    int playMode(GameModeId mode, Bot &bot, Pcg32 &botRng, DifficultyEngine &difficulty, uint32_t seed,
+                 unsigned long &durationMs)
+    {
+        switch (mode)
+        {
+        case MODE_REVERSE:
+            return playGame<ReverseMode>(bot, botRng, difficulty, seed, durationMs);
+        case MODE_TIME_ATTACK:
+            return playGame<TimeAttackMode>(bot, botRng, difficulty, seed, durationMs);
+        case MODE_DOUBLE_STEP:
+            return playGame<DoubleStepMode>(bot, botRng, difficulty, seed, durationMs);
+        default:
+            return playGame<ClassicMode>(bot, botRng, difficulty, seed, durationMs);
+        }
+    }
+
+    // Sleeps for ms of real time unless the step ends first.
+    bool sleepUnlessStopped(Step &step, double ms)
+    {
+        std::unique_lock<std::mutex> guard(step.lock);
+        return !step.wake.wait_for(guard, std::chrono::duration<double, std::milli>(ms),
+                                   [&]() { return step.stop.load(); });
+    }
+
+    template <class Bot>
+    void runDevice(Step &step, int index, Bot bot)
+    {
+        const Options &options = *step.options;
+        Pcg32 rng(options.seed * 2654435761u + index);
+        DifficultyEngine difficulty;
+        char deviceId[13];
+        snprintf(deviceId, sizeof(deviceId), "24A16%07X", (unsigned)index);
+        std::vector<Submission> results;
+        bool first = true;
+
+        while (!step.stop)
+        {
+            uint32_t seed = rng.next();
+            unsigned long durationMs;
+            difficulty.reset(); // a new player at every game
+            int score = playMode(options.mode, bot, rng, difficulty, seed, durationMs);
+            step.games++;
+            double realMs = durationMs / options.speed;
+            if (first)
+            {
+                realMs *= unitFloat(rng); // stagger: cabinets are mid-game when the step starts
+                first = false;
+            }
+            if (!sleepUnlessStopped(step, realMs))
+            {
+                break;
+            }
+
+            Clock::time_point startedAt = Clock::now();
+            Outcome outcome = upload(step.backend, step.host, 1000 + index, score, seed, options.mode, deviceId);
+            Clock::time_point doneAt = Clock::now();
+            results.push_back({outcome,
+                               (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(doneAt - startedAt).count(),
+                               doneAt <= step.windowEnd});
+        }
+
+        std::lock_guard<std::mutex> guard(step.resultsLock);
+        step.results.insert(step.results.end(), results.begin(), results.end());
+    }
+
+    void *deviceMain(void *arg)
+    {
+        Device *device = (Device *)arg;
+        Step &step = *device->step;
+        const char *bot = step.options->bot;
+        if (strcmp(bot, "perfect") == 0)
+        {
+            runDevice(step, device->index, PerfectBot());
+        }
+        else if (strncmp(bot, "span:", 5) == 0)
+        {
+            MemorySpanBot span;
+            span.spanMean = atof(bot + 5);
+            runDevice(step, device->index, span);
+        }
+        else
+        {
+            ErrorRateBot error;
+            if (strncmp(bot, "error:", 6) == 0)
+            {
+                error.errorRate = atof(bot + 6);
+            }
+            runDevice(step, device->index, error);
+        }
+        return nullptr;
+    }
+
+    uint32_t percentile(const std::vector<uint32_t> &sorted, double fraction)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        size_t i = std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+        return sorted[i];
+    }
+
+    void report(const Options &options, int devices, Step &step, double seconds)
+    {
+        unsigned long long outcomes[OUTCOME_COUNT] = {};
+        unsigned long long okInWindow = 0;
+        std::vector<uint32_t> latencies;
+        for (const Submission &s : step.results)
+        {
+            outcomes[s.outcome]++;
+            if (s.outcome == OUTCOME_OK)
+            {
+                latencies.push_back(s.latencyUs);
+                okInWindow += s.inWindow;
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        unsigned long long failed = step.results.size() - outcomes[OUTCOME_OK];
+
+        printf("%6d %9.1f %9.1f %8.1f %8.1f %8.1f %8.1f %7llu", devices, step.games / seconds, okInWindow / seconds,
+               percentile(latencies, 0.50) / 1000.0, percentile(latencies, 0.95) / 1000.0,
+               percentile(latencies, 0.99) / 1000.0, latencies.empty() ? 0.0 : latencies.back() / 1000.0, failed);
+        for (int i = 1; i < OUTCOME_COUNT; i++)
+        {
+            if (outcomes[i])
+            {
+                printf("  %s %llu", OUTCOME_NAMES[i], outcomes[i]);
+            }
+        }
+        printf("\n");
+        (void)options;
+    }
+
+    bool resolveBackend(const char *spec, sockaddr_in &address, char *host, size_t hostSize)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%s", spec);
+        char *colon = strrchr(name, ':');
+        if (!colon)
+        {
+            return false;
+        }
+        *colon = '\0';
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *found = nullptr;
+        if (getaddrinfo(name, colon + 1, &hints, &found) != 0)
+        {
+            return false;
+        }
+        address = *(sockaddr_in *)found->ai_addr;
+        freeaddrinfo(found);
+        snprintf(host, hostSize, "%s", spec);
+        return true;
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char *name = argv[i];
+            const char *value = argv[i + 1];
+            if (strcmp(name, "--devices") == 0)
+            {
+                options.devices.clear();
+                for (const char *p = value; *p; p = strchr(p, ',') ? strchr(p, ',') + 1 : p + strlen(p))
+                {
+                    options.devices.push_back(atoi(p));
+                }
+            }
+            else if (strcmp(name, "--seconds") == 0)
+            {
+                options.seconds = atof(value);
+            }
+            else if (strcmp(name, "--speed") == 0)
+            {
+                options.speed = atof(value);
+            }
+            else if (strcmp(name, "--bot") == 0)
+            {
+                snprintf(options.bot, sizeof(options.bot), "%s", value);
+            }
+            else if (strcmp(name, "--backend") == 0)
+            {
+                snprintf(options.backend, sizeof(options.backend), "%s", value);
+            }
+            else if (strcmp(name, "--workers") == 0)
+            {
+                options.workers = atoi(value);
+            }
+            else if (strcmp(name, "--service-ms") == 0)
+            {
+                options.serviceMs = atoi(value);
+            }
+            else if (strcmp(name, "--backlog") == 0)
+            {
+                options.backlog = atoi(value);
+            }
+            else if (strcmp(name, "--seed") == 0)
+            {
+                options.seed = strtoul(value, nullptr, 10);
+            }
+            else if (strcmp(name, "--mode") == 0)
+            {
+                const char *modes[MODE_COUNT] = {"classic", "reverse", "time", "double"};
+                int found = -1;
+                for (int m = 0; m < MODE_COUNT; m++)
+                {
+                    if (strcmp(value, modes[m]) == 0)
+                    {
+                        found = m;
+                    }
+                }
+                if (found < 0)
+                {
+                    return false;
+                }
+                options.mode = (GameModeId)found;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        for (int devices : options.devices)
+        {
+            if (devices <= 0)
+            {
+                return false;
+            }
+        }
+        return argc % 2 == 1 && !options.devices.empty() && options.speed > 0 && options.workers > 0;
+    }
+
+    // Every cabinet holds one socket while it uploads, the stand-in one per
+    // queued connection.
+    void raiseFileLimit(int devices)
+    {
+        rlimit limit;
+        getrlimit(RLIMIT_NOFILE, &limit);
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur < (rlim_t)devices * 2 + 64)
+        {
+            fprintf(stderr, "warning: %llu file descriptors for %d cabinets; expect socket errors\n",
+                    (unsigned long long)limit.rlim_cur, devices);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--devices N,N,...] [--seconds S] [--speed X] [--mode classic|reverse|time|double]\n"
+                        "       [--bot perfect|error:<rate>|span:<mean>] [--backend HOST:PORT] [--workers N]\n"
+                        "       [--service-ms N] [--backlog N] [--seed S]\n",
+                argv[0]);
+        return 2;
+    }
+    raiseFileLimit(*std::max_element(options.devices.begin(), options.devices.end()));
+
+    StandIn standIn;
+    sockaddr_in backend = {};
+    char host[64];
+    if (options.backend[0])
+    {
+        if (!resolveBackend(options.backend, backend, host, sizeof(host)))
+        {
+            fprintf(stderr, "cannot resolve %s\n", options.backend);
+            return 2;
+        }
+        printf("backend %s\n", host);
+    }
+    else
+    {
+        if (!standIn.start(options))
+        {
+            perror("stand-in");
+            return 1;
+        }
+        backend.sin_family = AF_INET;
+        backend.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        backend.sin_port = htons(standIn.port());
+        snprintf(host, sizeof(host), "127.0.0.1:%d", standIn.port());
+        printf("stand-in on %s: %d workers, %d ms per submission (capacity %.0f/s), backlog %d\n", host,
+               options.workers, options.serviceMs, options.serviceMs ? options.workers * 1000.0 / options.serviceMs : 0.0,
+               options.backlog);
+    }
+    printf("mode %s, bot %s, %.0fx game speed, %.0f s per step\n\n", GAME_MODE_NAMES[options.mode], options.bot,
+           options.speed, options.seconds);
+    printf("%6s %9s %9s %8s %8s %8s %8s %7s\n", "cabs", "games/s", "submit/s", "p50 ms", "p95 ms", "p99 ms", "max ms",
+           "failed");
+
+    for (int devices : options.devices)
+    {
+        Step step;
+        step.options = &options;
+        step.backend = backend;
+        snprintf(step.host, sizeof(step.host), "%s", host);
+        step.windowEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(options.seconds));
+
+        std::vector<Device> cabinets(devices);
+        std::vector<pthread_t> threads;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, DEVICE_STACK);
+        for (int i = 0; i < devices; i++)
+        {
+            cabinets[i] = {&step, i};
+            pthread_t thread;
+            if (pthread_create(&thread, &attr, deviceMain, &cabinets[i]) != 0)
+            {
+                fprintf(stderr, "only %d cabinet threads could start\n", i);
+                break;
+            }
+            threads.push_back(thread);
+        }
+        pthread_attr_destroy(&attr);
+
+        std::this_thread::sleep_until(step.windowEnd);
+        {
+            std::lock_guard<std::mutex> guard(step.lock);
+            step.stop = true;
+        }
+        step.wake.notify_all();
+        for (pthread_t thread : threads)
+        {
+            pthread_join(thread, nullptr); // uploads in flight finish within their timeouts
+        }
+        report(options, (int)threads.size(), step, options.seconds);
+    }
+
+    if (!options.backend[0])
+    {
+        standIn.stop();
+        printf("\nstand-in served %llu, rejected %llu\n", standIn.served(), standIn.rejected());
+    }
+    return 0;
+}
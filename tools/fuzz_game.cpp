@@ -0,0 +1,303 @@
+// Coverage-guided fuzzing of the game rules (GameCore + DifficultyEngine).
+//
+// Each game runs through the firmware's own flow (playRounds in
+// game_flow.h) on the host VirtualBoard (virtual_board.h), with a player
+// that reads the fuzz input as a stream of events: it answers with
+// arbitrary buttons after arbitrary reaction times, the web app changes
+// the difficulty target before any press, and new players log in between
+// games. The game's hooks check the invariants below at every round and
+// press and abort on a violation.
+//
+// Build with libFuzzer (clang):
+//     clang++ -g -O1 -std=c++17 -fsanitize=fuzzer,address,undefined -Iinclude -Itools
+//         tools/fuzz_game.cpp src/difficulty.cpp -o fuzz_game
+//     ./fuzz_game -print_final_stats=1 tools/fuzz_corpus
+// libFuzzer reports exec/s itself. Toolchains without libFuzzer can build
+// the standalone driver, which replays the corpus and then random inputs:
+//     g++ -O1 -std=c++17 -DFUZZ_STANDALONE -fsanitize=address,undefined -Iinclude -Itools
+//         tools/fuzz_game.cpp src/difficulty.cpp -o fuzz_game
+//     ./fuzz_game tools/fuzz_corpus/* --runs 200000
+//
+// Input layout:
+//     byte 0      bits 0-1 game mode, bit 2 SeededSequence storage
+//     byte 1      sequence cap - 1 (1..256 steps)
+//     bytes 2-5   seed
+//     events...   0x00-0xdf  press: button = byte % 5, reaction time from
+//                            the next two bytes (times 65536 if bit 7 set)
+//                 0xe0-0xfe  /difficulty?target= (byte & 31) / 31
+//                 0xff       stop pressing: the game is abandoned after
+//                            PRESS_ABANDON_MS; next byte odd = a new player
+//                            logs in
+// A game is also abandoned when the input runs out mid-round. Reaction
+// times past PRESS_ABANDON_MS, or past a time-attack window, end the game
+// through the flow's own timeouts.
+//
+// Device-side waits that the rules cannot see (button release, prompts,
+// volume and login from the web) are bounded by the timeouts in main.cpp
+// and game_flow.h; the game loop itself is iterative, so stack use does not
+// grow with the sequence length.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "game_core.h"
+#include "virtual_board.h"
+
+#define FUZZ_CHECK(condition)                                                         \
+    do                                                                                \
+    {                                                                                 \
+        if (!(condition))                                                             \
+        {                                                                             \
+            fprintf(stderr, "invariant failed: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            abort();                                                                  \
+        }                                                                             \
+    } while (0)
+
+namespace
+{
+    const size_t MAX_FUZZ_STEPS = 256;
+    const unsigned long POLL_MS = 1000; // timeouts land within a tick; presses land exactly
+
+    struct Input
+    {
+        const uint8_t *data;
+        size_t size;
+        size_t pos;
+
+        bool empty() const { return pos >= size; }
+        uint8_t byte() { return pos < size ? data[pos++] : 0; }
+    };
+
+    void checkDifficulty(const DifficultyEngine &difficulty)
+    {
+        const DifficultyState &state = difficulty.state();
+        FUZZ_CHECK(state.level >= 0 && state.level <= DIFFICULTY_LEVELS - 1);
+        FUZZ_CHECK(state.targetSuccess >= 0.5f && state.targetSuccess <= 0.95f);
+        FUZZ_CHECK(state.errorRate >= 0 && state.errorRate <= 1);
+        FUZZ_CHECK(isfinite(state.reactionMeanMs) && state.reactionMeanMs >= 0);
+        FUZZ_CHECK(isfinite(state.reactionVarMs2) && state.reactionVarMs2 >= 0);
+
+        const Tempo &tempo = difficulty.tempo();
+        FUZZ_CHECK(tempo.stepMs >= 200 && tempo.stepMs <= 800);
+        FUZZ_CHECK(tempo.gapMs >= 60 && tempo.gapMs <= 300);
+        FUZZ_CHECK(tempo.feedbackMs >= 120 && tempo.feedbackMs <= 300);
+        FUZZ_CHECK(difficulty.stepsPerRound() == 1 || difficulty.stepsPerRound() == 2);
+    }
+
+    // gameOver() and /difficulty print the state into a DIFFICULTY_JSON_MAX buffer.
+    // Checked once per input: snprintf of floats would otherwise dominate exec/s.
+    void checkDifficultyJson(const DifficultyEngine &difficulty)
+    {
+        char json[DIFFICULTY_JSON_MAX];
+        FUZZ_CHECK(difficulty.toJson(json, sizeof(json)) < sizeof(json));
+    }
+
+    // Plays the fuzz input and checks the game from the hooks the board
+    // passes on.
+    template <class Mode>
+    struct FuzzPlayer : PlayerEvents
+    {
+        Input &in;
+        DifficultyEngine &difficulty;
+        size_t maxSteps;
+        std::vector<uint8_t> shadow; // every step as it was first generated
+        size_t rounds = 0;
+        int score = 0;
+        uint8_t lastExpected = 0;
+        bool stopped = false;
+        bool marathon = false;
+
+        FuzzPlayer(Input &in, DifficultyEngine &difficulty, size_t maxSteps)
+            : in(in), difficulty(difficulty), maxSteps(maxSteps)
+        {
+        }
+
+        template <class Core>
+        void onRoundStart(const Core &core, int added)
+        {
+            FUZZ_CHECK(added >= 1 && added <= 2);
+            FUZZ_CHECK(core.length() == shadow.size() + added && core.length() <= maxSteps);
+            FUZZ_CHECK(++rounds <= maxSteps); // every round adds a step
+            for (size_t i = shadow.size(); i < core.length(); i++)
+            {
+                shadow.push_back(core.sequence()[i]);
+                FUZZ_CHECK(shadow.back() < 5);
+            }
+            checkDifficulty(difficulty);
+        }
+
+        uint8_t press(size_t step, uint8_t expected, Pcg32 &, unsigned long &reactionMs)
+        {
+            // Stored steps must never change while the sequence grows.
+            FUZZ_CHECK(expected == shadow[Mode::Order::index(step, shadow.size())]);
+            lastExpected = expected;
+            reactionMs = 0;
+            while (!stopped && !in.empty())
+            {
+                uint8_t event = in.byte();
+                if (event == 0xff)
+                {
+                    stopped = true;
+                    break;
+                }
+                if (event >= 0xe0)
+                {
+                    difficulty.setTarget((event & 31) / 31.0f);
+                    checkDifficulty(difficulty);
+                    continue;
+                }
+                reactionMs = (in.byte() << 8) | in.byte();
+                if (event & 0x80)
+                {
+                    reactionMs *= 65536;
+                }
+                return event % 5;
+            }
+            return NO_PRESS; // nobody pressing: the flow abandons the game
+        }
+
+        void onPress(int button, unsigned long, bool correct)
+        {
+            FUZZ_CHECK(correct == (button == lastExpected));
+            checkDifficulty(difficulty);
+        }
+
+        void onRoundCleared(int total)
+        {
+            FUZZ_CHECK(total > score); // scores only increase within a game
+            score = total;
+            checkDifficulty(difficulty);
+        }
+
+        void onGameEnd(GameEnd why) { marathon = why == GAME_END_MARATHON; }
+    };
+
+    // One game. Returns false once the input is used up.
+    template <class Mode, class Sequence>
+    bool playGame(Input &in, Sequence &sequence, Pcg32 &rng, DifficultyEngine &difficulty, size_t maxSteps,
+                  uint32_t seed)
+    {
+        typedef GameCore<Mode, Sequence> Core;
+        Core core(sequence, rng, difficulty, maxSteps);
+        core.start(seed);
+
+        FuzzPlayer<Mode> player(in, difficulty, maxSteps);
+        Pcg32 unused;
+        VirtualBoard<Core, FuzzPlayer<Mode>> board(core, player, unused, 0, POLL_MS);
+        int score = 0;
+        playRounds(board, core, score);
+        FUZZ_CHECK(score == player.score);
+        FUZZ_CHECK(!player.marathon || core.length() == maxSteps);
+        return !in.empty();
+    }
+
+    template <class Sequence>
+    void playSession(Input &in, Sequence &sequence, int mode, size_t maxSteps, uint32_t seed)
+    {
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        for (uint32_t game = 0;; game++)
+        {
+            bool more;
+            switch (mode)
+            {
+            case MODE_REVERSE:
+                more = playGame<ReverseMode>(in, sequence, rng, difficulty, maxSteps, seed + game);
+                break;
+            case MODE_TIME_ATTACK:
+                more = playGame<TimeAttackMode>(in, sequence, rng, difficulty, maxSteps, seed + game);
+                break;
+            case MODE_DOUBLE_STEP:
+                more = playGame<DoubleStepMode>(in, sequence, rng, difficulty, maxSteps, seed + game);
+                break;
+            default:
+                more = playGame<ClassicMode>(in, sequence, rng, difficulty, maxSteps, seed + game);
+                break;
+            }
+            if (!more || in.empty())
+            {
+                checkDifficultyJson(difficulty);
+                return;
+            }
+            if (in.byte() & 1)
+            {
+                difficulty.reset(); // greetPlayer() for the next player in the queue
+                checkDifficulty(difficulty);
+            }
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 6)
+    {
+        return 0;
+    }
+    Input in = {data, size, 6};
+    int mode = data[0] & 3;
+    size_t maxSteps = 1 + data[1];
+    uint32_t seed = data[2] | (data[3] << 8) | (data[4] << 16) | ((uint32_t)data[5] << 24);
+
+    if (data[0] & 4)
+    {
+        static SeededSequence seeded;
+        playSession(in, seeded, mode, maxSteps, seed);
+    }
+    else
+    {
+        static PackedSequence<MAX_FUZZ_STEPS> packed;
+        playSession(in, packed, mode, maxSteps, seed);
+    }
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+#include <chrono>
+
+// Minimal driver for toolchains without libFuzzer: runs the given corpus
+// files once, then --runs N random inputs, and reports executions per second.
+int main(int argc, char **argv)
+{
+    unsigned long runs = 100000;
+    std::vector<uint8_t> buffer;
+    size_t files = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            runs = strtoul(argv[++i], nullptr, 10);
+            continue;
+        }
+        FILE *f = fopen(argv[i], "rb");
+        if (!f)
+        {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 2;
+        }
+        buffer.resize(1 << 16);
+        buffer.resize(fread(buffer.data(), 1, buffer.size(), f));
+        fclose(f);
+        LLVMFuzzerTestOneInput(buffer.data(), buffer.size());
+        files++;
+    }
+
+    Pcg32 rng(1);
+    auto startedAt = std::chrono::steady_clock::now();
+    for (unsigned long run = 0; run < runs; run++)
+    {
+        buffer.resize(6 + rng.bounded(2048));
+        for (uint8_t &byte : buffer)
+        {
+            byte = (uint8_t)rng.next();
+        }
+        LLVMFuzzerTestOneInput(buffer.data(), buffer.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+    printf("%zu corpus files, %lu random runs in %.2f s, %.0f exec/s\n", files, runs, seconds, runs / seconds);
+    return 0;
+}
+#endif
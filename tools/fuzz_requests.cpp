@@ -0,0 +1,209 @@
+// Coverage-guided fuzzing of the web app's request bodies: /esp-login and
+// /set-volume, decoded as JSON or MessagePack by the firmware's own
+// wireDecode() (wire_codec.h) into a document on a 4 KB bump arena, as
+// RequestScope does, then checked by the handlers' field checks
+// (request_fields.h). Every input checks the invariants below and aborts
+// on a violation.
+//
+// Builds against the ArduinoJson copy PlatformIO fetched for the firmware
+// (pio run once, to populate .pio/libdeps). With libFuzzer (clang):
+//     clang++ -g -O1 -std=c++17 -fsanitize=fuzzer,address,undefined -Iinclude
+//         -I.pio/libdeps/esp32dev/ArduinoJson/src tools/fuzz_requests.cpp -o fuzz_requests
+//     ./fuzz_requests -print_final_stats=1 tools/fuzz_corpus_requests
+// Toolchains without libFuzzer can build the standalone driver, which
+// replays the corpus and then random mutations of it:
+//     g++ -O1 -std=c++17 -DFUZZ_STANDALONE -fsanitize=address,undefined -Iinclude
+//         -I.pio/libdeps/esp32dev/ArduinoJson/src tools/fuzz_requests.cpp -o fuzz_requests
+//     ./fuzz_requests tools/fuzz_corpus_requests/* --runs 200000
+//
+// Input layout:
+//     byte 0      bit 0: /set-volume instead of /esp-login
+//                 bit 1: Content-Type application/msgpack instead of JSON
+//     bytes 1..   the request body
+// Bodies longer than WIRE_MAX_BODY are rejected by wireCaptureBody() before
+// they are decoded, so they are skipped here.
+//
+// Invariants: an accepted login has a positive user id, a non-empty
+// username, its volume in 0..30 or absent (-1) and its sound one of
+// SOUND_FOLDERS or absent (0); an accepted /set-volume has its volume in
+// 0..30; a rejected body is rejected with a reply text; and every
+// accepted or rejected document re-encodes (the handlers' replies) within
+// WIRE_MAX_BODY or reports that it does not fit.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "bump_arena.h"
+#include "request_fields.h"
+#include "wire_codec.h"
+
+#define FUZZ_CHECK(condition)                                                         \
+    do                                                                                \
+    {                                                                                 \
+        if (!(condition))                                                             \
+        {                                                                             \
+            fprintf(stderr, "invariant failed: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            abort();                                                                  \
+        }                                                                             \
+    } while (0)
+
+namespace
+{
+    const size_t ARENA_SIZE = 4096; // REQUEST_ARENA_SIZE in request_arena.h
+
+    alignas(max_align_t) uint8_t memory[ARENA_SIZE];
+    BumpArena arena(memory, sizeof(memory));
+
+    class ArenaJsonAllocator : public ArduinoJson::Allocator
+    {
+    public:
+        void *allocate(size_t size) override { return arena.allocate(size); }
+        void deallocate(void *) override {}
+        void *reallocate(void *ptr, size_t size) override { return arena.reallocate(ptr, size); }
+    };
+    ArenaJsonAllocator allocator;
+
+    void checkLogin(const JsonDocument &doc)
+    {
+        LoginFields login;
+        FieldCheck check = checkLoginFields(doc, login);
+        FUZZ_CHECK(check >= FIELDS_OK && check <= FIELDS_BAD_USER);
+        if (check != FIELDS_OK)
+        {
+            FUZZ_CHECK(FIELD_CHECK_ERRORS[check][0] != '\0');
+            return;
+        }
+        FUZZ_CHECK(login.volume == -1 || (login.volume >= 0 && login.volume <= VOLUME_MAX));
+        FUZZ_CHECK(login.folder == 0 || soundFolderValid(login.folder));
+        FUZZ_CHECK(login.userId > 0);
+        FUZZ_CHECK(login.username != nullptr && login.username[0] != '\0');
+        FUZZ_CHECK(strlen(login.username) < WIRE_MAX_BODY); // strings come out of the body
+    }
+
+    void checkVolume(const JsonDocument &doc)
+    {
+        int volume = -1;
+        FieldCheck check = checkVolumeFields(doc, volume);
+        FUZZ_CHECK(check == FIELDS_OK || check == FIELDS_BAD_VOLUME);
+        FUZZ_CHECK(check != FIELDS_OK || (volume >= 0 && volume <= VOLUME_MAX));
+    }
+
+    void checkReencode(const JsonDocument &doc, WireFormat format)
+    {
+        uint8_t out[WIRE_MAX_BODY];
+        size_t length = wireEncode(doc, out, sizeof(out), format);
+        size_t needed = format == WIRE_MSGPACK ? measureMsgPack(doc) : measureJson(doc) + 1; // + NUL
+        FUZZ_CHECK(length == 0 ? needed > sizeof(out) : length <= sizeof(out));
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 1 || size - 1 > WIRE_MAX_BODY)
+    {
+        return 0;
+    }
+    bool setVolume = data[0] & 1;
+    WireFormat format = data[0] & 2 ? WIRE_MSGPACK : WIRE_JSON;
+
+    // The handler's copy: wireCaptureBody() keeps the body in its own buffer.
+    uint8_t body[WIRE_MAX_BODY];
+    memcpy(body, data + 1, size - 1);
+
+    arena.reset();
+    {
+        JsonDocument doc(&allocator);
+        if (!wireDecode(doc, body, size - 1, format))
+        {
+            if (setVolume)
+            {
+                checkVolume(doc);
+            }
+            else
+            {
+                checkLogin(doc);
+            }
+            checkReencode(doc, format);
+        }
+    }
+    FUZZ_CHECK(arena.peak() <= ARENA_SIZE);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+#include <chrono>
+
+#include "pcg32.h"
+
+// Minimal driver for toolchains without libFuzzer: runs the given corpus
+// files once, then --runs N mutations of them (byte flips, inserted and
+// deleted bytes, digits and JSON punctuation), and reports executions per
+// second.
+int main(int argc, char **argv)
+{
+    unsigned long runs = 100000;
+    std::vector<std::vector<uint8_t>> corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            runs = strtoul(argv[++i], nullptr, 10);
+            continue;
+        }
+        FILE *f = fopen(argv[i], "rb");
+        if (!f)
+        {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 2;
+        }
+        std::vector<uint8_t> input(1 << 16);
+        input.resize(fread(input.data(), 1, input.size(), f));
+        fclose(f);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        corpus.push_back(input);
+    }
+    if (corpus.empty())
+    {
+        corpus.push_back({0});
+    }
+
+    static const char TOKENS[] = "{}[]\":,-.0123456789eE \\nulltruefalse";
+    Pcg32 rng(1);
+    std::vector<uint8_t> buffer;
+    auto startedAt = std::chrono::steady_clock::now();
+    for (unsigned long run = 0; run < runs; run++)
+    {
+        buffer = corpus[rng.bounded(corpus.size())];
+        int mutations = 1 + rng.bounded(8);
+        for (int m = 0; m < mutations && !buffer.empty(); m++)
+        {
+            size_t at = rng.bounded(buffer.size());
+            switch (rng.bounded(4))
+            {
+            case 0:
+                buffer[at] ^= (uint8_t)(1 << rng.bounded(8));
+                break;
+            case 1:
+                buffer[at] = (uint8_t)TOKENS[rng.bounded(sizeof(TOKENS) - 1)];
+                break;
+            case 2:
+                buffer.insert(buffer.begin() + at, (uint8_t)rng.next());
+                break;
+            default:
+                if (at > 0)
+                {
+                    buffer.erase(buffer.begin() + at);
+                }
+                break;
+            }
+        }
+        LLVMFuzzerTestOneInput(buffer.data(), buffer.size());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+    printf("%zu corpus files, %lu mutated runs in %.2f s, %.0f exec/s\n", corpus.size(), runs, seconds,
+           runs / seconds);
+    return 0;
+}
+#endif
@@ -0,0 +1,323 @@
+// Golden timing check: scripted games on a virtual clock, compared with
+// committed timelines.
+//
+//     g++ -O2 -std=c++17 -Iinclude -Itools tools/golden_timing.cpp src/difficulty.cpp -o golden_timing
+//     ./golden_timing                   compare with tools/golden_timing/*.txt
+//     ./golden_timing --update          rewrite the golden files after an intended change
+//
+// Each scenario plays one game through the firmware's own flow
+// (game_flow.h) and rules (game_core.h) on the host VirtualBoard
+// (virtual_board.h), the same board the simulator and fuzzer use. The
+// board keeps the clock, answers button reads from a scripted player and
+// writes down every LED, sound and LCD change, every press and release,
+// and the round and game boundaries. The result is a timeline in milliseconds, one
+// event per line.
+//
+// A run fails (exit status 1) when the event sequence differs from the
+// golden file, or when the time between two consecutive events moved by
+// more than the tolerance: --tolerance-ms (default 2) or --tolerance-pct
+// of the golden gap (default 2), whichever is larger. That catches changed
+// round durations, step spacing, debounce and feedback times and input
+// windows (the time-attack and abandon scenarios end on their timeouts).
+// Every round whose duration changed is listed with old and new values.
+//
+// The board polls every 1 ms; the cabinet's loop polls faster, so input
+// timings here are exact to within that tick.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "game_core.h"
+#include "virtual_board.h"
+
+namespace
+{
+    const size_t MAX_STEPS = 64;
+
+    // The scripted player: presses each step reactionMs after the prompt
+    // and holds it for holdMs. In wrongRound it presses the wrong button on
+    // the first step; from silentRound on it stops pressing. 0 = never.
+    struct ScriptedPlayer : PlayerEvents
+    {
+        unsigned long reactionMs;
+        unsigned long holdMs;
+        int wrongRound;
+        int silentRound;
+        int round = 0;
+
+        ScriptedPlayer(unsigned long reactionMs, unsigned long holdMs, int wrongRound, int silentRound)
+            : reactionMs(reactionMs), holdMs(holdMs), wrongRound(wrongRound), silentRound(silentRound)
+        {
+        }
+
+        template <class Core>
+        void onRoundStart(const Core &, int)
+        {
+            round++;
+        }
+
+        uint8_t press(size_t step, uint8_t expected, Pcg32 &, unsigned long &pressMs)
+        {
+            pressMs = reactionMs;
+            if (silentRound && round >= silentRound)
+            {
+                return NO_PRESS;
+            }
+            return round == wrongRound && step == 0 ? (expected + 1) % 5 : expected;
+        }
+    };
+
+    struct Scenario
+    {
+        const char *name;
+        GameModeId mode;
+        uint32_t seed;
+        size_t maxSteps;
+        ScriptedPlayer player;
+    };
+
+    // Cover each mode's playback and input rules, both ends of the
+    // difficulty engine's tempo and every way a game can end.
+    const Scenario SCENARIOS[] = {
+        {"classic_steady", MODE_CLASSIC, 7, MAX_STEPS, {450, 120, 7, 0}},
+        {"classic_fast_player", MODE_CLASSIC, 11, MAX_STEPS, {180, 60, 9, 0}},
+        {"classic_abandoned", MODE_CLASSIC, 3, MAX_STEPS, {500, 150, 0, 3}},
+        {"reverse_mistake", MODE_REVERSE, 5, MAX_STEPS, {600, 120, 4, 0}},
+        {"time_attack_slow", MODE_TIME_ATTACK, 9, MAX_STEPS, {4200, 200, 0, 0}},
+        {"time_attack_timeout", MODE_TIME_ATTACK, 13, MAX_STEPS, {700, 120, 0, 3}},
+        {"double_step", MODE_DOUBLE_STEP, 21, MAX_STEPS, {400, 100, 5, 0}},
+        {"marathon", MODE_CLASSIC, 17, 6, {350, 100, 0, 0}},
+    };
+
+    template <class Mode>
+    std::vector<TimelineEvent> play(const Scenario &scenario)
+    {
+        static PackedSequence<MAX_STEPS> sequence;
+        Pcg32 rng;
+        DifficultyEngine difficulty;
+        typedef GameCore<Mode, PackedSequence<MAX_STEPS>> Core;
+        Core core(sequence, rng, difficulty, scenario.maxSteps);
+        core.start(scenario.seed);
+
+        ScriptedPlayer player = scenario.player;
+        Pcg32 unused;
+        std::vector<TimelineEvent> timeline;
+        VirtualBoard<Core, ScriptedPlayer> board(core, player, unused, player.holdMs, 1, &timeline);
+        int score = 0;
+        playRounds(board, core, score);
+        return timeline;
+    }
+
+    std::vector<TimelineEvent> run(const Scenario &scenario)
+    {
+        switch (scenario.mode)
+        {
+        case MODE_REVERSE:
+            return play<ReverseMode>(scenario);
+        case MODE_TIME_ATTACK:
+            return play<TimeAttackMode>(scenario);
+        case MODE_DOUBLE_STEP:
+            return play<DoubleStepMode>(scenario);
+        default:
+            return play<ClassicMode>(scenario);
+        }
+    }
+
+    std::string header(const Scenario &s)
+    {
+        char text[256];
+        snprintf(text, sizeof(text),
+                 "# %s: %s, seed %u, max %u steps; reaction %lu ms, hold %lu ms, wrong press in round %d, silent from "
+                 "round %d (0 = never)\n",
+                 s.name, GAME_MODE_NAMES[s.mode], (unsigned)s.seed, (unsigned)s.maxSteps, s.player.reactionMs,
+                 s.player.holdMs, s.player.wrongRound, s.player.silentRound);
+        return text;
+    }
+
+    bool writeGolden(const std::string &path, const Scenario &scenario, const std::vector<TimelineEvent> &timeline)
+    {
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f)
+        {
+            return false;
+        }
+        fputs(header(scenario).c_str(), f);
+        for (const TimelineEvent &event : timeline)
+        {
+            fprintf(f, "%8lu %s\n", event.at, event.text.c_str());
+        }
+        fclose(f);
+        return true;
+    }
+
+    bool readGolden(const std::string &path, std::vector<TimelineEvent> &timeline)
+    {
+        FILE *f = fopen(path.c_str(), "r");
+        if (!f)
+        {
+            return false;
+        }
+        char line[256];
+        while (fgets(line, sizeof(line), f))
+        {
+            if (line[0] == '#')
+            {
+                continue;
+            }
+            char *text;
+            unsigned long at = strtoul(line, &text, 10);
+            while (*text == ' ')
+            {
+                text++;
+            }
+            text[strcspn(text, "\n")] = '\0';
+            timeline.push_back({at, text});
+        }
+        fclose(f);
+        return true;
+    }
+
+    struct Tolerance
+    {
+        double ms;
+        double pct;
+
+        bool within(long golden, long actual) const
+        {
+            double allowed = fmax(ms, fabs((double)golden) * pct / 100);
+            return fabs((double)(actual - golden)) <= allowed;
+        }
+    };
+
+    // Start time of each round plus the end of the game, from the timeline.
+    std::vector<unsigned long> roundBoundaries(const std::vector<TimelineEvent> &timeline)
+    {
+        std::vector<unsigned long> bounds;
+        for (const TimelineEvent &event : timeline)
+        {
+            if (event.text.compare(0, 6, "ROUND ") == 0)
+            {
+                bounds.push_back(event.at);
+            }
+        }
+        if (!timeline.empty())
+        {
+            bounds.push_back(timeline.back().at);
+        }
+        return bounds;
+    }
+
+    // Prints every difference; returns the number of failures.
+    int compare(const char *name, const std::vector<TimelineEvent> &golden, const std::vector<TimelineEvent> &actual,
+                const Tolerance &tolerance)
+    {
+        int failures = 0;
+        size_t common = golden.size() < actual.size() ? golden.size() : actual.size();
+        for (size_t i = 0; i < common; i++)
+        {
+            if (golden[i].text != actual[i].text)
+            {
+                printf("%s: event %zu at %lu ms is \"%s\", golden has \"%s\" at %lu ms\n", name, i, actual[i].at,
+                       actual[i].text.c_str(), golden[i].text.c_str(), golden[i].at);
+                return failures + 1; // the timelines diverge; later gaps mean nothing
+            }
+            if (i == 0)
+            {
+                continue;
+            }
+            long goldenGap = golden[i].at - golden[i - 1].at;
+            long actualGap = actual[i].at - actual[i - 1].at;
+            if (!tolerance.within(goldenGap, actualGap))
+            {
+                printf("%s: %lu ms between \"%s\" and \"%s\" (event %zu), golden %ld ms\n", name,
+                       (unsigned long)actualGap, actual[i - 1].text.c_str(), actual[i].text.c_str(), i, goldenGap);
+                failures++;
+            }
+        }
+        if (golden.size() != actual.size())
+        {
+            printf("%s: %zu events, golden has %zu\n", name, actual.size(), golden.size());
+            failures++;
+        }
+
+        std::vector<unsigned long> goldenRounds = roundBoundaries(golden);
+        std::vector<unsigned long> actualRounds = roundBoundaries(actual);
+        for (size_t r = 0; r + 1 < goldenRounds.size() && r + 1 < actualRounds.size(); r++)
+        {
+            long goldenMs = goldenRounds[r + 1] - goldenRounds[r];
+            long actualMs = actualRounds[r + 1] - actualRounds[r];
+            if (!tolerance.within(goldenMs, actualMs))
+            {
+                printf("%s: round %zu takes %ld ms, golden %ld ms (%+.1f%%)\n", name, r + 1, actualMs, goldenMs,
+                       goldenMs ? 100.0 * (actualMs - goldenMs) / goldenMs : 0.0);
+            }
+        }
+        return failures;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string dir = "tools/golden_timing";
+    Tolerance tolerance = {2, 2};
+    bool update = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+        {
+            update = true;
+        }
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+        {
+            dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance-ms") == 0 && i + 1 < argc)
+        {
+            tolerance.ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tolerance-pct") == 0 && i + 1 < argc)
+        {
+            tolerance.pct = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--update] [--dir DIR] [--tolerance-ms MS] [--tolerance-pct PCT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int failed = 0;
+    for (const Scenario &scenario : SCENARIOS)
+    {
+        std::vector<TimelineEvent> timeline = run(scenario);
+        std::string path = dir + "/" + scenario.name + ".txt";
+        unsigned long total = timeline.empty() ? 0 : timeline.back().at;
+
+        if (update)
+        {
+            if (!writeGolden(path, scenario, timeline))
+            {
+                fprintf(stderr, "cannot write %s\n", path.c_str());
+                return 2;
+            }
+            printf("%-22s %5zu events, %7lu ms  written\n", scenario.name, timeline.size(), total);
+            continue;
+        }
+
+        std::vector<TimelineEvent> golden;
+        if (!readGolden(path, golden))
+        {
+            printf("%s: no golden file %s (run with --update)\n", scenario.name, path.c_str());
+            failed++;
+            continue;
+        }
+        int failures = compare(scenario.name, golden, timeline, tolerance);
+        printf("%-22s %5zu events, %7lu ms  %s\n", scenario.name, timeline.size(), total, failures ? "FAIL" : "ok");
+        failed += failures ? 1 : 0;
+    }
+    return failed ? 1 : 0;
+}
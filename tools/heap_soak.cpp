@@ -0,0 +1,409 @@
+// Host soak for heap fragmentation: 1,000 games played through the
+// firmware's game loop (game_flow.h on a VirtualBoard), with the heap
+// work of each game replayed against a model of the ESP32 heap, once with
+// the Arduino Strings the game used to build and once with FixedString.
+//
+//     g++ -O2 -std=c++17 -Iinclude -Itools tools/heap_soak.cpp src/difficulty.cpp -o heap_soak
+//     ./heap_soak --games 1000
+//
+// Options:
+//     --games N      games per variant (default 1000)
+//     --heap-kb N    free heap when the soak starts (default 110, about
+//                    what the cabinet has left with Wi-Fi and the web
+//                    server up)
+//     --error R      the bot's slip rate per press (default 0.05, games
+//                    of about 15 rounds)
+//     --seed S
+//
+// The model follows ESP-IDF 4.4's multi_heap, which Arduino-ESP32 2.x
+// uses: 4-byte aligned blocks with an 8-byte header, best fit over an
+// address-ordered free list, neighbours merged on free, realloc growing
+// in place when the next block is free. ModelString grows the way
+// Arduino's String does, by realloc to exactly the new length.
+//
+// Per game, both variants do the same library work, which the firmware
+// does not control: the HTTPClient upload (its header Strings and a
+// receive buffer, all freed after the request), the WebServer's request
+// Strings on every player change, and lwIP keeping each closed
+// connection's control block for a while (TIME_WAIT) so it is freed two
+// games later. The "string" variant adds what the game itself built
+// before FixedString: the "Score: N" line twice per round, the folder
+// name once per game, the login user id and username, and the score
+// upload's JSON body grown by ArduinoJson's 32-byte String writer.
+//
+// Fragmentation is the firmware's memory_telemetry.cpp figure, 100 - 100
+// * largest free block / total free, sampled at every game over as
+// gameOver() does. This is a model: it shows which allocation pattern
+// fragments and how fast, not the exact numbers of a given device.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include "fixed_string.h"
+#include "game_core.h"
+#include "virtual_board.h"
+
+namespace
+{
+    const size_t STORAGE_STEPS = 10000;
+
+    class ModelHeap
+    {
+    public:
+        static const size_t HEADER = 8;
+        static const size_t MIN_BLOCK = 16; // header plus the free-list links
+
+        explicit ModelHeap(size_t size) { free_[0] = size; }
+
+        // Offset of the payload, or SIZE_MAX when nothing fits.
+        size_t allocate(size_t size)
+        {
+            size_t need = blockSize(size);
+            auto best = free_.end();
+            for (auto it = free_.begin(); it != free_.end(); ++it)
+            {
+                if (it->second >= need && (best == free_.end() || it->second < best->second))
+                {
+                    best = it;
+                }
+            }
+            if (best == free_.end())
+            {
+                failures_++;
+                return SIZE_MAX;
+            }
+            size_t at = best->first;
+            size_t rest = best->second - need;
+            free_.erase(best);
+            if (rest >= MIN_BLOCK)
+            {
+                free_[at + need] = rest;
+            }
+            else
+            {
+                need += rest;
+            }
+            used_[at] = need;
+            allocations_++;
+            return at + HEADER;
+        }
+
+        void release(size_t payload)
+        {
+            if (payload == SIZE_MAX)
+            {
+                return;
+            }
+            size_t at = payload - HEADER;
+            size_t size = used_.at(at);
+            used_.erase(at);
+            auto next = free_.find(at + size);
+            if (next != free_.end())
+            {
+                size += next->second;
+                free_.erase(next);
+            }
+            auto prev = free_.lower_bound(at);
+            if (prev != free_.begin() && (--prev)->first + prev->second == at)
+            {
+                prev->second += size;
+                return;
+            }
+            free_[at] = size;
+        }
+
+        size_t reallocate(size_t payload, size_t size)
+        {
+            if (payload == SIZE_MAX)
+            {
+                return allocate(size);
+            }
+            size_t at = payload - HEADER;
+            size_t have = used_.at(at);
+            size_t need = blockSize(size);
+            if (need <= have)
+            {
+                return payload; // multi_heap keeps the block when shrinking by a little
+            }
+            auto next = free_.find(at + have);
+            if (next != free_.end() && have + next->second >= need)
+            {
+                size_t rest = have + next->second - need;
+                free_.erase(next);
+                if (rest >= MIN_BLOCK)
+                {
+                    free_[at + need] = rest;
+                }
+                else
+                {
+                    need += rest;
+                }
+                used_[at] = need;
+                return payload;
+            }
+            size_t moved = allocate(size);
+            release(payload);
+            return moved;
+        }
+
+        size_t freeBytes() const
+        {
+            size_t total = 0;
+            for (const auto &block : free_)
+            {
+                total += block.second - HEADER;
+            }
+            return total;
+        }
+
+        size_t largestBlock() const
+        {
+            size_t largest = 0;
+            for (const auto &block : free_)
+            {
+                largest = std::max(largest, block.second - HEADER);
+            }
+            return largest;
+        }
+
+        unsigned long allocations() const { return allocations_; }
+        unsigned long failures() const { return failures_; }
+
+    private:
+        static size_t blockSize(size_t size) { return std::max(MIN_BLOCK, HEADER + ((size + 3) & ~(size_t)3)); }
+
+        std::map<size_t, size_t> free_;             // offset -> block size, address order
+        std::unordered_map<size_t, size_t> used_;   // offset -> block size
+        unsigned long allocations_ = 0;
+        unsigned long failures_ = 0;
+    };
+
+    // Arduino String's allocation behaviour: a buffer of exactly length + 1,
+    // realloc'd on every concatenation, freed by the destructor.
+    class ModelString
+    {
+    public:
+        ModelString(ModelHeap &heap, size_t length) : heap_(heap) { concat(length); }
+        ~ModelString() { heap_.release(buffer_); }
+        ModelString(const ModelString &) = delete;
+        ModelString &operator=(const ModelString &) = delete;
+
+        void concat(size_t length)
+        {
+            length_ += length;
+            buffer_ = heap_.reallocate(buffer_, length_ + 1);
+        }
+
+    private:
+        ModelHeap &heap_;
+        size_t buffer_ = SIZE_MAX;
+        size_t length_ = 0;
+    };
+
+    size_t decimalLength(long value)
+    {
+        char text[INT_TEXT_MAX];
+        return formatInt(text, value);
+    }
+
+    // The heap work around one game, in the order the firmware does it.
+    class GameHeapWork
+    {
+    public:
+        GameHeapWork(ModelHeap &heap, bool strings) : heap_(heap), strings_(strings) {}
+
+        // A new player logged in through the web app.
+        void login(long userId)
+        {
+            ModelString uri(heap_, 10);    // WebServer: the URI,
+            ModelString body(heap_, 72);   // the "plain" body argument
+            ModelString header(heap_, 16); // and a Content-Type header
+            if (strings_)
+            {
+                ModelString id(heap_, decimalLength(userId)); // String(doc["user_id"]).toInt()
+                username_.reset(new ModelString(heap_, 8));    // the username global
+            }
+        }
+
+        void startGame()
+        {
+            if (strings_)
+            {
+                ModelString folder(heap_, 7); // the sound menu's folder name
+            }
+        }
+
+        // showScore() at Simon's turn and again at "Your Turn".
+        void round(int score)
+        {
+            if (!strings_)
+            {
+                FixedString<16> line("Score: ");
+                line += score;
+                return;
+            }
+            for (int i = 0; i < 2; i++)
+            {
+                ModelString number(heap_, decimalLength(score)); // String(score)
+                ModelString line(heap_, 7);                      // "Score: " + ...
+                line.concat(decimalLength(score));
+            }
+        }
+
+        void upload(int score)
+        {
+            std::unique_ptr<ModelString> json;
+            if (strings_)
+            {
+                // serializeJson(doc, String) appends in chunks of up to 31 bytes.
+                size_t length = 60 + decimalLength(score);
+                json.reset(new ModelString(heap_, std::min<size_t>(length, 31)));
+                for (size_t written = 31; written < length; written += 31)
+                {
+                    json->concat(std::min<size_t>(length - written, 31));
+                }
+            }
+            ModelString url(heap_, 40); // HTTPClient: URL parts and headers
+            ModelString host(heap_, 13);
+            ModelString headers(heap_, 0);
+            headers.concat(38);
+            headers.concat(44);
+            size_t client = heap_.allocate(1436); // WiFiClient receive buffer
+            ModelString status(heap_, 15);
+            heap_.release(client);
+            json.reset();
+
+            // The closed connection's PCB stays in TIME_WAIT for a while.
+            timeWait_.push_back(heap_.allocate(160));
+            if (timeWait_.size() > 2)
+            {
+                heap_.release(timeWait_.front());
+                timeWait_.erase(timeWait_.begin());
+            }
+        }
+
+    private:
+        ModelHeap &heap_;
+        bool strings_;
+        std::unique_ptr<ModelString> username_;
+        std::vector<size_t> timeWait_;
+    };
+
+    // ErrorRateBot whose games drive the heap work from the game's hooks.
+    struct SoakPlayer : ErrorRateBot
+    {
+        GameHeapWork *work = nullptr;
+        int score = 0;
+
+        template <class Core>
+        void onRoundStart(const Core &, int)
+        {
+            work->round(score);
+        }
+
+        void onRoundCleared(int total) { score = total; }
+    };
+
+    struct Options
+    {
+        int games = 1000;
+        size_t heapKb = 110;
+        float errorRate = 0.05f;
+        uint32_t seed = 1;
+    };
+
+    void soak(const Options &options, bool strings)
+    {
+        ModelHeap heap(options.heapKb * 1024);
+        GameHeapWork work(heap, strings);
+        static PackedSequence<STORAGE_STEPS> sequence;
+        DifficultyEngine difficulty;
+        Pcg32 rng;
+        Pcg32 botRng(options.seed);
+
+        printf("%s\n", strings ? "Arduino String (before)" : "FixedString (now)");
+        printf("%8s %10s %10s %8s %8s %12s\n", "games", "free", "largest", "frag %", "worst %", "allocs/game");
+        unsigned worst = 0;
+        unsigned long allocationsBefore = heap.allocations();
+        for (int game = 1; game <= options.games; game++)
+        {
+            if (game % 5 == 1)
+            {
+                work.login(1000 + game); // a new player every few games
+            }
+            work.startGame();
+
+            SoakPlayer player;
+            player.errorRate = options.errorRate;
+            player.work = &work;
+            GameCore<ClassicMode, PackedSequence<STORAGE_STEPS>> core(sequence, rng, difficulty, STORAGE_STEPS);
+            VirtualBoard<decltype(core), SoakPlayer> board(core, player, botRng, 80, 10);
+            difficulty.reset();
+            core.start(options.seed + game);
+            int score = 0;
+            playRounds(board, core, score);
+            work.upload(score);
+
+            // gameOver()'s sample
+            size_t free = heap.freeBytes();
+            size_t largest = heap.largestBlock();
+            unsigned fragmentation = free ? 100 - (unsigned)((uint64_t)100 * largest / free) : 0;
+            worst = std::max(worst, fragmentation);
+            if (game % 100 == 0 || game == 1)
+            {
+                printf("%8d %10zu %10zu %8u %8u %12.1f\n", game, free, largest, fragmentation, worst,
+                       (double)(heap.allocations() - allocationsBefore) / game);
+            }
+        }
+        printf("%lu failed allocations\n\n", heap.failures());
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char *name = argv[i];
+            const char *value = argv[i + 1];
+            if (strcmp(name, "--games") == 0)
+            {
+                options.games = atoi(value);
+            }
+            else if (strcmp(name, "--heap-kb") == 0)
+            {
+                options.heapKb = strtoul(value, nullptr, 10);
+            }
+            else if (strcmp(name, "--error") == 0)
+            {
+                options.errorRate = atof(value);
+            }
+            else if (strcmp(name, "--seed") == 0)
+            {
+                options.seed = strtoul(value, nullptr, 10);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return argc % 2 == 1 && options.games > 0 && options.heapKb > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--games N] [--heap-kb N] [--error R] [--seed S]\n", argv[0]);
+        return 2;
+    }
+    soak(options, true);
+    soak(options, false);
+    return 0;
+}
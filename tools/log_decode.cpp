@@ -0,0 +1,74 @@
+// Expands a binary log capture from firmware built with -DSIMON_LOG_BINARY.
+//
+//     g++ -O2 -std=c++17 -Iinclude tools/log_decode.cpp -o log_decode
+//     ./log_decode capture.bin        (or: ./log_decode < capture.bin)
+//
+// Capture the raw UART, e.g. `cat /dev/ttyUSB0 > capture.bin`. The stream
+// mixes checksummed log frames (log_messages.h) with ordinary Serial text
+// from the rest of the firmware; frames are expanded with the same message
+// table the firmware was built with, everything else is passed through.
+// Timestamps are unwrapped from the frames' 32-bit microsecond clock, so
+// they stay correct across the 71-minute wrap as long as the device logs
+// at least once per wrap.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "log_messages.h"
+
+int main(int argc, char **argv)
+{
+    FILE *in = argc > 1 ? fopen(argv[1], "rb") : stdin;
+    if (!in)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 2;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+
+    uint64_t epochUs = 0;
+    uint32_t lastUs = 0;
+    bool seen = false;
+    size_t frames = 0;
+    size_t rejected = 0;
+    char line[256];
+    for (size_t i = 0; i < data.size();)
+    {
+        LogRecord record;
+        if (data.size() - i >= LOG_FRAME_SIZE && data[i] == LOG_FRAME_SYNC[0] &&
+            logDecodeFrame(&data[i], record))
+        {
+            // Moved forward but numerically back: the 32-bit clock wrapped. A
+            // record slightly older than the previous one (logged from the
+            // other core) is not a wrap.
+            if (seen && record.atUs < lastUs && (uint32_t)(record.atUs - lastUs) < 0x80000000u)
+            {
+                epochUs += 1ull << 32;
+            }
+            seen = true;
+            lastUs = record.atUs;
+            uint64_t atUs = epochUs + record.atUs;
+            logFormat(line, sizeof(line), record);
+            printf("[%6llu.%03llu] %s\n", (unsigned long long)(atUs / 1000000),
+                   (unsigned long long)(atUs / 1000 % 1000), line);
+            frames++;
+            i += LOG_FRAME_SIZE;
+            continue;
+        }
+        if (data[i] == LOG_FRAME_SYNC[0] && i + 1 < data.size() && data[i + 1] == LOG_FRAME_SYNC[1])
+        {
+            rejected++; // sync bytes in plain text, or a frame damaged on the wire
+        }
+        putchar(data[i]);
+        i++;
+    }
+    fprintf(stderr, "%zu log frames, %zu sync patterns passed through as text\n", frames, rejected);
+    return 0;
+}
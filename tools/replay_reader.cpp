@@ -0,0 +1,286 @@
+// Reads and plays back the SSR1 game replays the cabinet keeps on LittleFS
+// (format in replay.h; download one from /replay?slot=N).
+//
+//     g++ -O2 -std=c++17 -Iinclude tools/replay_reader.cpp -o replay_reader
+//     ./replay_reader 3.bin [more.bin...]     timeline and verdict
+//     ./replay_reader --live 3.bin            same, paced in real time
+//
+// Playing back checks the replay against the firmware's own rules
+// (game_modes.h): every press against the step the mode expects, the
+// score rebuilt round by round against the recorded final score, and the
+// recorded sequence against the one the seed regenerates, with either
+// sequence storage (game_core.h). A replay whose buffer was never flushed
+// (power lost mid-game) ends without a game-over record and is reported
+// as truncated.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "game_modes.h"
+#include "packed_sequence.h"
+#include "pcg32.h"
+
+namespace
+{
+    const uint8_t CODE_STEP = 5;
+    const uint8_t CODE_GAME_OVER = 15;
+    const size_t HEADER_SIZE = 14;
+
+    struct Record
+    {
+        unsigned long atMs; // since the replay started
+        uint8_t code;
+    };
+
+    struct Replay
+    {
+        uint32_t game = 0;
+        uint32_t seed = 0;
+        uint8_t folder = 0;
+        uint8_t mode = 0;
+        std::vector<Record> records;
+        bool finished = false;
+        uint32_t score = 0;
+    };
+
+    uint32_t readU32(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // False when the varint runs past the end of the data.
+    bool readVarint(const std::vector<uint8_t> &data, size_t &at, uint32_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35 && at < data.size(); shift += 7)
+        {
+            uint8_t byte = data[at++];
+            value |= (uint32_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parse(const std::vector<uint8_t> &data, Replay &replay, const char *&error)
+    {
+        if (data.size() < HEADER_SIZE || memcmp(data.data(), "SSR1", 4) != 0)
+        {
+            error = "not an SSR1 replay";
+            return false;
+        }
+        replay.game = readU32(&data[4]);
+        replay.seed = readU32(&data[8]);
+        replay.folder = data[12];
+        replay.mode = data[13];
+        if (replay.mode >= MODE_COUNT)
+        {
+            error = "unknown game mode";
+            return false;
+        }
+
+        unsigned long atMs = 0;
+        size_t at = HEADER_SIZE;
+        while (at < data.size())
+        {
+            uint32_t value;
+            if (!readVarint(data, at, value))
+            {
+                break; // cut off mid-record
+            }
+            atMs += value >> 4;
+            uint8_t code = value & 0x0f;
+            if (code == CODE_GAME_OVER)
+            {
+                replay.finished = readVarint(data, at, replay.score);
+                break;
+            }
+            if (code >= CODE_STEP + 5)
+            {
+                error = "unknown record code";
+                return false;
+            }
+            replay.records.push_back({atMs, code});
+        }
+        return true;
+    }
+
+    // Do the recorded steps come out of the seed, as PackedSequence (PCG32
+    // draws) or SeededSequence (hash of seed and index) builds make them?
+    const char *seedStorage(const Replay &replay)
+    {
+        Pcg32 rng;
+        rng.reseed(replay.seed);
+        SeededSequence seeded;
+        seeded.reset(replay.seed);
+        bool packed = true;
+        bool hashed = true;
+        size_t index = 0;
+        for (const Record &record : replay.records)
+        {
+            if (record.code < CODE_STEP)
+            {
+                continue;
+            }
+            uint8_t step = record.code - CODE_STEP;
+            packed &= rng.bounded(5) == step;
+            hashed &= seeded[index++] == step;
+        }
+        return packed ? "packed" : hashed ? "seeded" : nullptr;
+    }
+
+    void pause(unsigned long ms)
+    {
+        timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000};
+        nanosleep(&ts, nullptr);
+    }
+
+    // Plays the records through Mode's rules; returns the rebuilt score and
+    // counts presses that do not match what the mode expects.
+    template <class Mode>
+    int play(const Replay &replay, bool live, int &mismatches)
+    {
+        std::vector<uint8_t> sequence;
+        size_t pressed = 0;
+        int score = 0;
+        unsigned long lastMs = 0;
+        for (const Record &record : replay.records)
+        {
+            if (live)
+            {
+                pause(record.atMs - lastMs);
+            }
+            unsigned long deltaMs = record.atMs - lastMs;
+            lastMs = record.atMs;
+            if (record.code >= CODE_STEP)
+            {
+                sequence.push_back(record.code - CODE_STEP);
+                pressed = 0;
+                printf("%8lu  +%-6lu SIMON  %d (length %zu)\n", record.atMs, deltaMs, record.code - CODE_STEP,
+                       sequence.size());
+                continue;
+            }
+            if (pressed >= sequence.size())
+            {
+                printf("%8lu  +%-6lu PRESS  %d  unexpected: round already complete\n", record.atMs, deltaMs,
+                       record.code);
+                mismatches++;
+                continue;
+            }
+            uint8_t expected = sequence[Mode::Order::index(pressed, sequence.size())];
+            bool correct = record.code == expected;
+            mismatches += correct ? 0 : 1;
+            if (correct)
+            {
+                printf("%8lu  +%-6lu PRESS  %d  ok\n", record.atMs, deltaMs, record.code);
+            }
+            else
+            {
+                printf("%8lu  +%-6lu PRESS  %d  wrong, expected %d\n", record.atMs, deltaMs, record.code, expected);
+            }
+            if (correct && ++pressed == sequence.size())
+            {
+                score += Mode::Scoring::roundPoints(sequence.size());
+                printf("%8s  %-7s ROUND  cleared, score %d\n", "", "", score);
+            }
+        }
+        return score;
+    }
+
+    int play(const Replay &replay, bool live, int &mismatches)
+    {
+        switch (replay.mode)
+        {
+        case MODE_REVERSE:
+            return play<ReverseMode>(replay, live, mismatches);
+        case MODE_TIME_ATTACK:
+            return play<TimeAttackMode>(replay, live, mismatches);
+        case MODE_DOUBLE_STEP:
+            return play<DoubleStepMode>(replay, live, mismatches);
+        default:
+            return play<ClassicMode>(replay, live, mismatches);
+        }
+    }
+
+    bool readFile(const char *path, std::vector<uint8_t> &data)
+    {
+        FILE *in = fopen(path, "rb");
+        if (!in)
+        {
+            return false;
+        }
+        uint8_t chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+        {
+            data.insert(data.end(), chunk, chunk + n);
+        }
+        fclose(in);
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool live = false;
+    int files = 0;
+    int failed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--live") == 0)
+        {
+            live = true;
+            continue;
+        }
+        files++;
+        std::vector<uint8_t> data;
+        if (!readFile(argv[i], data))
+        {
+            fprintf(stderr, "%s: cannot open\n", argv[i]);
+            failed++;
+            continue;
+        }
+        Replay replay;
+        const char *error = nullptr;
+        if (!parse(data, replay, error))
+        {
+            fprintf(stderr, "%s: %s\n", argv[i], error);
+            failed++;
+            continue;
+        }
+
+        printf("%s: game %u, seed %u, %s, sound folder %u, %zu bytes\n", argv[i], replay.game, replay.seed,
+               GAME_MODE_NAMES[replay.mode], replay.folder, data.size());
+        printf("%8s  %-7s\n", "ms", "delta");
+        int mismatches = 0;
+        int score = play(replay, live, mismatches);
+
+        const char *storage = seedStorage(replay);
+        bool scoreMatches = replay.finished && (int)replay.score == score;
+        if (replay.finished)
+        {
+            printf("\nrecorded score %u, rebuilt %d%s\n", replay.score, score, scoreMatches ? "" : "  MISMATCH");
+        }
+        else
+        {
+            printf("\nno game-over record (truncated), rebuilt score %d\n", score);
+        }
+        printf("presses against the rules: %d mismatched (the game-ending wrong press counts as one)\n",
+               mismatches);
+        printf("sequence from the seed: %s\n\n",
+               storage ? (strcmp(storage, "packed") == 0 ? "matches (PackedSequence build)"
+                                                         : "matches (SeededSequence build)")
+                       : "DOES NOT MATCH");
+        failed += scoreMatches && storage ? 0 : 1;
+    }
+    if (files == 0)
+    {
+        fprintf(stderr, "usage: %s [--live] replay.bin...\n", argv[0]);
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
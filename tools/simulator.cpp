@@ -0,0 +1,540 @@
+// Headless Simon simulator: runs the real game flow and rules (game_flow.h,
+// GameCore, the DifficultyEngine and the mode policies) against scripted
+// bots on a virtual clock, spread over every core with a work-stealing
+// pool.
+//
+// Build and run on the host:
+//     g++ -O2 -std=c++17 -Iinclude -Itools tools/simulator.cpp src/difficulty.cpp -pthread -o simulator
+//     ./simulator --games 1000000 --bot error:0.02 --mode classic
+//
+// Options:
+//     --games N         games to play (default 100000)
+//     --threads N       worker threads (default: hardware concurrency)
+//     --mode M          classic | reverse | time | double
+//     --bot B           perfect | error:<rate> | span:<mean>
+//     --target T        difficulty target success rate (default 0.8)
+//     --max-steps N     sequence cap (default 500; the device allows 10000,
+//                       but a perfect bot would then spend all the time in
+//                       one marathon)
+//     --seed S          base seed; game g uses a hash of (S, g), so results
+//                       do not depend on the thread count
+//     --tempo T         engine (default) | old: the tempo before the
+//                       difficulty engine, for comparing game lengths
+//     --poll-ms N       virtual input poll tick (default 10)
+//
+// Every game runs through playRounds() on the host VirtualBoard
+// (virtual_board.h), the board the golden timing check uses, so playback,
+// debounce, feedback, timeouts and the round pause are the firmware's own.
+// Presses land exactly at the bot's reaction time; only time-ups and
+// abandons can move, by less than --poll-ms.
+//
+// --tempo old replays the firmware as it was before the difficulty engine:
+// one new step per round, 800 ms per step shortened after every playback
+// by score / 10 down to 200 ms, 300 ms gaps, and the 500 ms wait every
+// sound used to add to each step and each press. Running the same bot and
+// seed with both tempos compares how long games last.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "game_core.h"
+#include "virtual_board.h"
+
+namespace
+{
+    const size_t STORAGE_STEPS = 10000; // same storage as the firmware
+    const size_t BATCH_GAMES = 256;
+    const int SCORE_BUCKETS = 4096;     // scores are binned by 10 points
+
+    struct Options
+    {
+        unsigned long long games = 100000;
+        unsigned threads = 0;
+        GameModeId mode = MODE_CLASSIC;
+        char bot[32] = "error:0.02";
+        float target = 0.8f;
+        size_t maxSteps = 500;
+        uint32_t seed = 1;
+        bool oldTempo = false;
+        unsigned long pollMs = 10;
+        unsigned long holdMs = 80; // how long a bot keeps a button down
+    };
+
+    struct GameResult
+    {
+        int score;
+        size_t length;
+        unsigned long presses;
+        unsigned long durationMs;
+    };
+
+    // Per-worker accumulators, padded so workers never share a cache line.
+    struct alignas(64) Totals
+    {
+        unsigned long long games = 0;
+        unsigned long long presses = 0;
+        double scoreSum = 0;
+        double lengthSum = 0;
+        double durationSum = 0;
+        int maxScore = 0;
+        size_t maxLength = 0;
+        std::vector<uint32_t> scoreHistogram = std::vector<uint32_t>(SCORE_BUCKETS);
+        std::vector<uint32_t> durationHistogram = std::vector<uint32_t>(3600); // 1 s bins, 1 h cap
+
+        void add(const GameResult &game)
+        {
+            games++;
+            presses += game.presses;
+            scoreSum += game.score;
+            lengthSum += game.length;
+            durationSum += game.durationMs;
+            maxScore = std::max(maxScore, game.score);
+            maxLength = std::max(maxLength, game.length);
+            scoreHistogram[std::min(game.score / 10, SCORE_BUCKETS - 1)]++;
+            durationHistogram[std::min<size_t>(game.durationMs / 1000, durationHistogram.size() - 1)]++;
+        }
+
+        void merge(const Totals &other)
+        {
+            games += other.games;
+            presses += other.presses;
+            scoreSum += other.scoreSum;
+            lengthSum += other.lengthSum;
+            durationSum += other.durationSum;
+            maxScore = std::max(maxScore, other.maxScore);
+            maxLength = std::max(maxLength, other.maxLength);
+            for (size_t i = 0; i < scoreHistogram.size(); i++)
+            {
+                scoreHistogram[i] += other.scoreHistogram[i];
+            }
+            for (size_t i = 0; i < durationHistogram.size(); i++)
+            {
+                durationHistogram[i] += other.durationHistogram[i];
+            }
+        }
+    };
+
+    // Game g's seed, independent of which worker plays it.
+    uint32_t gameSeed(uint32_t base, unsigned long long game)
+    {
+        uint64_t x = ((uint64_t)base << 32) ^ game;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return (uint32_t)x;
+    }
+
+    // Mode's rules with the pre-engine tempo: one step per round, and
+    // the old delayBetweenSteps = max(200, delayBetweenSteps - score / 10)
+    // applied after each playback. The difficulty engine still records the
+    // presses but no longer sets the pace.
+    template <class Mode>
+    class OldTempoCore
+    {
+    public:
+        typedef GameMode<FixedExtension<1>, typename Mode::Order, typename Mode::Timing, typename Mode::Scoring>
+            OneStepMode;
+
+        OldTempoCore(PackedSequence<STORAGE_STEPS> &sequence, Pcg32 &rng, DifficultyEngine &difficulty,
+                     size_t maxSteps)
+            : core_(sequence, rng, difficulty, maxSteps)
+        {
+        }
+
+        void start(uint32_t seed)
+        {
+            core_.start(seed);
+            delayMs_ = 800;
+            score_ = 0;
+        }
+
+        int extend()
+        {
+            tempo_.stepMs = SOUND_WAIT_MS + delayMs_;
+            tempo_.gapMs = 300;
+            tempo_.feedbackMs = SOUND_WAIT_MS + 300;
+            delayMs_ = std::max(200, delayMs_ - score_ / 10);
+            return core_.extend();
+        }
+
+        size_t length() const { return core_.length(); }
+        const PackedSequence<STORAGE_STEPS> &sequence() const { return core_.sequence(); }
+        uint8_t expected(size_t press) const { return core_.expected(press); }
+        bool press(size_t index, uint8_t button, unsigned long reactionMs)
+        {
+            return core_.press(index, button, reactionMs);
+        }
+
+        int roundCleared()
+        {
+            int points = core_.roundCleared();
+            score_ += points;
+            return points;
+        }
+
+        bool expired(unsigned long now, unsigned long gameStartedAt, unsigned long promptedAt) const
+        {
+            return core_.expired(now, gameStartedAt, promptedAt);
+        }
+
+        const Tempo &tempo() const { return tempo_; }
+
+    private:
+        static const int SOUND_WAIT_MS = 500; // playInFolder() waited this long after every command
+
+        GameCore<OneStepMode, PackedSequence<STORAGE_STEPS>> core_;
+        Tempo tempo_ = {};
+        int delayMs_ = 800;
+        int score_ = 0;
+    };
+
+    // One game through the firmware's flow.
+    template <class Core, class Bot>
+    GameResult playGame(const Options &options, Bot &bot, PackedSequence<STORAGE_STEPS> &sequence,
+                        DifficultyEngine &difficulty, uint32_t seed)
+    {
+        Pcg32 rng;
+        Pcg32 botRng(~seed);
+        Core core(sequence, rng, difficulty, options.maxSteps);
+        difficulty.reset();
+        core.start(seed);
+        bot.startGame(botRng);
+
+        VirtualBoard<Core, Bot> board(core, bot, botRng, options.holdMs, options.pollMs);
+        GameResult result = {0, 0, 0, 0};
+        playRounds(board, core, result.score);
+        result.length = core.length();
+        result.presses = board.presses();
+        result.durationMs = board.millis();
+        return result;
+    }
+
+    template <class Mode, class Bot>
+    GameResult playTempo(const Options &options, Bot &bot, PackedSequence<STORAGE_STEPS> &sequence,
+                         DifficultyEngine &difficulty, uint32_t seed)
+    {
+        if (options.oldTempo)
+        {
+            return playGame<OldTempoCore<Mode>>(options, bot, sequence, difficulty, seed);
+        }
+        return playGame<GameCore<Mode, PackedSequence<STORAGE_STEPS>>>(options, bot, sequence, difficulty, seed);
+    }
+
+    template <class Bot>
+    GameResult playMode(const Options &options, Bot &bot, PackedSequence<STORAGE_STEPS> &sequence,
+                        DifficultyEngine &difficulty, uint32_t seed)
+    {
+        switch (options.mode)
+        {
+        case MODE_REVERSE:
+            return playTempo<ReverseMode>(options, bot, sequence, difficulty, seed);
+        case MODE_TIME_ATTACK:
+            return playTempo<TimeAttackMode>(options, bot, sequence, difficulty, seed);
+        case MODE_DOUBLE_STEP:
+            return playTempo<DoubleStepMode>(options, bot, sequence, difficulty, seed);
+        default:
+            return playTempo<ClassicMode>(options, bot, sequence, difficulty, seed);
+        }
+    }
+
+    // A range of game numbers; the unit of work the pool hands out.
+    struct Batch
+    {
+        unsigned long long first;
+        unsigned long long count;
+    };
+
+    // Each worker pops batches from the back of its own deque and, once that
+    // is empty, steals from the front of another worker's. Batches are coarse
+    // (BATCH_GAMES games), so a mutex per deque is never contended for long.
+    class WorkStealingPool
+    {
+    public:
+        explicit WorkStealingPool(unsigned workers) : queues_(workers) {}
+
+        void distribute(unsigned long long games)
+        {
+            unsigned worker = 0;
+            for (unsigned long long first = 0; first < games; first += BATCH_GAMES)
+            {
+                queues_[worker].batches.push_back({first, std::min<unsigned long long>(BATCH_GAMES, games - first)});
+                worker = (worker + 1) % queues_.size();
+            }
+        }
+
+        bool next(unsigned self, Batch &batch)
+        {
+            if (popBack(queues_[self], batch))
+            {
+                return true;
+            }
+            for (size_t n = 1; n < queues_.size(); n++)
+            {
+                if (popFront(queues_[(self + n) % queues_.size()], batch))
+                {
+                    steals_++;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        unsigned long long steals() const { return steals_; }
+
+    private:
+        struct alignas(64) Queue
+        {
+            std::mutex lock;
+            std::deque<Batch> batches;
+        };
+
+        static bool popBack(Queue &queue, Batch &batch)
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (queue.batches.empty())
+            {
+                return false;
+            }
+            batch = queue.batches.back();
+            queue.batches.pop_back();
+            return true;
+        }
+
+        static bool popFront(Queue &queue, Batch &batch)
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (queue.batches.empty())
+            {
+                return false;
+            }
+            batch = queue.batches.front();
+            queue.batches.pop_front();
+            return true;
+        }
+
+        std::vector<Queue> queues_;
+        std::atomic<unsigned long long> steals_{0};
+    };
+
+    template <class Bot>
+    void runWorker(const Options &options, Bot bot, WorkStealingPool &pool, unsigned self, Totals &totals)
+    {
+        // Per-thread game state; nothing is shared while playing.
+        static thread_local PackedSequence<STORAGE_STEPS> sequence;
+        DifficultyEngine difficulty;
+        difficulty.setTarget(options.target);
+
+        Batch batch;
+        while (pool.next(self, batch))
+        {
+            for (unsigned long long g = batch.first; g < batch.first + batch.count; g++)
+            {
+                totals.add(playMode(options, bot, sequence, difficulty, gameSeed(options.seed, g)));
+            }
+        }
+    }
+
+    void startWorker(std::vector<std::thread> &threads, const Options &options, WorkStealingPool &pool,
+                     unsigned self, Totals &totals)
+    {
+        if (strcmp(options.bot, "perfect") == 0)
+        {
+            threads.emplace_back(runWorker<PerfectBot>, std::cref(options), PerfectBot(), std::ref(pool), self,
+                                 std::ref(totals));
+        }
+        else if (strncmp(options.bot, "span:", 5) == 0)
+        {
+            MemorySpanBot bot;
+            bot.spanMean = atof(options.bot + 5);
+            threads.emplace_back(runWorker<MemorySpanBot>, std::cref(options), bot, std::ref(pool), self,
+                                 std::ref(totals));
+        }
+        else
+        {
+            ErrorRateBot bot;
+            if (strncmp(options.bot, "error:", 6) == 0)
+            {
+                bot.errorRate = atof(options.bot + 6);
+            }
+            threads.emplace_back(runWorker<ErrorRateBot>, std::cref(options), bot, std::ref(pool), self,
+                                 std::ref(totals));
+        }
+    }
+
+    // Value below which `fraction` of the histogram's samples fall.
+    size_t percentile(const std::vector<uint32_t> &histogram, unsigned long long total, double fraction)
+    {
+        unsigned long long wanted = (unsigned long long)(fraction * total);
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < histogram.size(); i++)
+        {
+            seen += histogram[i];
+            if (seen > wanted)
+            {
+                return i;
+            }
+        }
+        return histogram.size() - 1;
+    }
+
+    void report(const Options &options, const Totals &totals, double seconds, unsigned threads,
+                unsigned long long steals)
+    {
+        printf("mode %s, bot %s, %s tempo, target %.2f, %llu games on %u threads\n", GAME_MODE_NAMES[options.mode],
+               options.bot, options.oldTempo ? "old" : "engine", options.target, totals.games, threads);
+        printf("wall time %.2f s, %.0f games/s, %.1f M presses/s, %llu steals\n", seconds,
+               totals.games / seconds, totals.presses / seconds / 1e6, steals);
+
+        printf("\nscore: mean %.1f, max %d\n", totals.scoreSum / totals.games, totals.maxScore);
+        const double marks[] = {0.10, 0.25, 0.50, 0.75, 0.90, 0.99};
+        for (double mark : marks)
+        {
+            printf("    p%-3.0f %zu\n", mark * 100, 10 * percentile(totals.scoreHistogram, totals.games, mark));
+        }
+
+        printf("\nlength: mean %.1f steps, max %zu\n", totals.lengthSum / totals.games, totals.maxLength);
+
+        printf("\nduration: mean %.1f s (virtual)\n", totals.durationSum / totals.games / 1000);
+        for (double mark : marks)
+        {
+            printf("    p%-3.0f %zu s\n", mark * 100, percentile(totals.durationHistogram, totals.games, mark));
+        }
+
+        // Coarse text histogram of scores, 20 bins up to p99.
+        size_t top = percentile(totals.scoreHistogram, totals.games, 0.99) + 1;
+        size_t width = (top + 19) / 20;
+        printf("\nscore histogram (bin = %zu points)\n", 10 * width);
+        unsigned long long peak = 1;
+        std::vector<unsigned long long> bins(20);
+        for (size_t i = 0; i < totals.scoreHistogram.size(); i++)
+        {
+            bins[std::min<size_t>(i / width, 19)] += totals.scoreHistogram[i];
+        }
+        for (unsigned long long count : bins)
+        {
+            peak = std::max(peak, count);
+        }
+        for (size_t b = 0; b < bins.size(); b++)
+        {
+            char bar[61];
+            size_t length = (size_t)(60 * bins[b] / peak);
+            memset(bar, '#', length);
+            bar[length] = '\0';
+            printf("    %6zu %8llu %s\n", 10 * width * b, bins[b], bar);
+        }
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char *name = argv[i];
+            const char *value = argv[i + 1];
+            if (strcmp(name, "--games") == 0)
+            {
+                options.games = strtoull(value, nullptr, 10);
+            }
+            else if (strcmp(name, "--threads") == 0)
+            {
+                options.threads = atoi(value);
+            }
+            else if (strcmp(name, "--bot") == 0)
+            {
+                snprintf(options.bot, sizeof(options.bot), "%s", value);
+            }
+            else if (strcmp(name, "--target") == 0)
+            {
+                options.target = atof(value);
+            }
+            else if (strcmp(name, "--max-steps") == 0)
+            {
+                options.maxSteps = std::min<size_t>(strtoul(value, nullptr, 10), STORAGE_STEPS);
+            }
+            else if (strcmp(name, "--seed") == 0)
+            {
+                options.seed = strtoul(value, nullptr, 10);
+            }
+            else if (strcmp(name, "--poll-ms") == 0)
+            {
+                options.pollMs = strtoul(value, nullptr, 10);
+            }
+            else if (strcmp(name, "--tempo") == 0)
+            {
+                if (strcmp(value, "old") != 0 && strcmp(value, "engine") != 0)
+                {
+                    return false;
+                }
+                options.oldTempo = strcmp(value, "old") == 0;
+            }
+            else if (strcmp(name, "--mode") == 0)
+            {
+                const char *modes[MODE_COUNT] = {"classic", "reverse", "time", "double"};
+                int found = -1;
+                for (int m = 0; m < MODE_COUNT; m++)
+                {
+                    if (strcmp(value, modes[m]) == 0)
+                    {
+                        found = m;
+                    }
+                }
+                if (found < 0)
+                {
+                    return false;
+                }
+                options.mode = (GameModeId)found;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return argc % 2 == 1 && options.games > 0 && options.pollMs > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--games N] [--threads N] [--mode classic|reverse|time|double]\n"
+                        "       [--bot perfect|error:<rate>|span:<mean>] [--target T] [--max-steps N] [--seed S]\n"
+                        "       [--tempo engine|old] [--poll-ms N]\n",
+                argv[0]);
+        return 2;
+    }
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    WorkStealingPool pool(threads);
+    pool.distribute(options.games);
+    std::vector<Totals> totals(threads);
+
+    auto startedAt = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++)
+    {
+        startWorker(workers, options, pool, t, totals[t]);
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+
+    for (unsigned t = 1; t < threads; t++)
+    {
+        totals[0].merge(totals[t]);
+    }
+    report(options, totals[0], seconds, threads, pool.steals());
+    return 0;
+}
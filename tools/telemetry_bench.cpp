@@ -0,0 +1,348 @@
+// Host benchmark for the /events telemetry stream: 20 subscribers on
+// loopback TCP, fed by the firmware's own framing and send queues
+// (sse_stream.h), measuring events/s delivered and the CPU time the
+// emitting loop spends per event.
+//
+//     g++ -O2 -std=c++17 -Iinclude tools/telemetry_bench.cpp -pthread -o telemetry_bench
+//     ./telemetry_bench --subscribers 20 --slow 2 --seconds 5 --frame-us 1000
+//
+// Options:
+//     --subscribers N       clients connected to the stream (default 20)
+//     --slow N              of those, clients that never read (default 2);
+//                           their queue overflows and they are dropped
+//     --seconds S           how long to stream (default 5)
+//     --events-per-frame N  events coalesced into each message (default 4)
+//     --frame-us N          pause between frames (default 1000). The game
+//                           flushes a frame per Simon step and per round,
+//                           a few per second, so 1000 frames/s is a
+//                           stress rate; 0 streams flat out, faster than
+//                           any reader keeps up, and drops everyone
+//
+// The emitting side mirrors telemetryPoll(): format the frame once,
+// enqueue it per subscriber and drain with non-blocking send(). Its CPU
+// time comes from CLOCK_THREAD_CPUTIME_ID around that work only, so the
+// reader threads and the pause are not counted. Each server socket's send
+// buffer is cut to 5744 bytes, the ESP32's default TCP_SND_BUF, and a
+// stalled client's receive window to 4 KB, so a stalled reader backs up
+// about as quickly as it would on the device.
+//
+// The device itself caps the stream at TELEMETRY_MAX_SUBSCRIBERS (4):
+// lwIP has 10 sockets in total and the web server needs its own. This
+// benchmark runs 20 to show how the cost grows per subscriber. Host
+// numbers are not ESP32 numbers; the per-subscriber slope is the useful
+// figure.
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "sse_stream.h"
+
+namespace
+{
+    const int QUEUE_SIZE = 512; // TELEMETRY_QUEUE_SIZE in telemetry.h
+    const int FRAME_SIZE = 192; // TELEMETRY_FRAME_SIZE in telemetry.h
+    const int DEVICE_SNDBUF = 5744;
+
+    struct Options
+    {
+        int subscribers = 20;
+        int slow = 2;
+        double seconds = 5;
+        int eventsPerFrame = 4;
+        long frameUs = 1000;
+    };
+
+    struct Subscriber
+    {
+        int fd = -1;
+        bool active = true;
+        SseQueue<QUEUE_SIZE> queue;
+    };
+
+    struct Received
+    {
+        std::atomic<unsigned long long> events{0};
+        std::atomic<unsigned long long> bytes{0};
+    };
+
+    double nowSeconds(clockid_t clock)
+    {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    // Counts events in "data: a;b;c\n\n" messages as they stream in.
+    void readAll(std::vector<int> fds, Received &received, std::atomic<bool> &stop)
+    {
+        std::vector<pollfd> polls;
+        for (int fd : fds)
+        {
+            polls.push_back({fd, POLLIN, 0});
+        }
+        std::vector<char> last(fds.size(), 0);
+        char buffer[4096];
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            if (poll(polls.data(), polls.size(), 50) <= 0)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < polls.size(); i++)
+            {
+                if (!(polls[i].revents & POLLIN))
+                {
+                    continue;
+                }
+                ssize_t n = read(polls[i].fd, buffer, sizeof(buffer));
+                if (n <= 0)
+                {
+                    polls[i].fd = -1; // dropped by the server
+                    continue;
+                }
+                unsigned long long events = 0;
+                for (ssize_t b = 0; b < n; b++)
+                {
+                    if (buffer[b] == ';' || (buffer[b] == '\n' && last[i] == '\n'))
+                    {
+                        events++; // one per separator, plus one per message end
+                    }
+                    last[i] = buffer[b];
+                }
+                received.events += events;
+                received.bytes += n;
+            }
+        }
+    }
+
+    bool connectPair(int listener, sockaddr_in &address, bool stalls, int &server, int &client)
+    {
+        client = socket(AF_INET, SOCK_STREAM, 0);
+        if (stalls)
+        {
+            int window = 4096;
+            setsockopt(client, SOL_SOCKET, SO_RCVBUF, &window, sizeof(window));
+        }
+        if (connect(client, (sockaddr *)&address, sizeof(address)) != 0)
+        {
+            return false;
+        }
+        server = accept(listener, nullptr, nullptr);
+        if (server < 0)
+        {
+            return false;
+        }
+        int one = 1;
+        setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(server, SOL_SOCKET, SO_SNDBUF, &DEVICE_SNDBUF, sizeof(DEVICE_SNDBUF));
+        fcntl(server, F_SETFL, fcntl(server, F_GETFL) | O_NONBLOCK);
+        return true;
+    }
+
+    // A round of Simon: start, playback steps, timed presses, score.
+    int scriptedEvent(unsigned long long n, int *fields, char &code)
+    {
+        int round = (int)(n / 24) + 1;
+        switch (n % 8)
+        {
+        case 0:
+            code = 'R';
+            fields[0] = round;
+            fields[1] = round;
+            return 2;
+        case 1:
+        case 2:
+        case 3:
+            code = 'S';
+            fields[0] = (int)(n % 8) - 1;
+            fields[1] = (int)(n % 4);
+            return 2;
+        case 7:
+            code = 'C';
+            fields[0] = round * 10;
+            return 1;
+        default:
+            code = 'P';
+            fields[0] = (int)(n % 4);
+            fields[1] = 300 + (int)(n % 250);
+            fields[2] = 1;
+            return 3;
+        }
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char *name = argv[i];
+            const char *value = argv[i + 1];
+            if (strcmp(name, "--subscribers") == 0)
+            {
+                options.subscribers = atoi(value);
+            }
+            else if (strcmp(name, "--slow") == 0)
+            {
+                options.slow = atoi(value);
+            }
+            else if (strcmp(name, "--seconds") == 0)
+            {
+                options.seconds = atof(value);
+            }
+            else if (strcmp(name, "--events-per-frame") == 0)
+            {
+                options.eventsPerFrame = atoi(value);
+            }
+            else if (strcmp(name, "--frame-us") == 0)
+            {
+                options.frameUs = atol(value);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return argc % 2 == 1 && options.subscribers > 0 && options.slow <= options.subscribers &&
+               options.eventsPerFrame > 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--subscribers N] [--slow N] [--seconds S] [--events-per-frame N] [--frame-us N]\n",
+                argv[0]);
+        return 2;
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressLength = sizeof(address);
+    if (bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 64) != 0 ||
+        getsockname(listener, (sockaddr *)&address, &addressLength) != 0)
+    {
+        perror("listen");
+        return 1;
+    }
+
+    std::vector<Subscriber> subscribers(options.subscribers);
+    std::vector<int> readers;
+    std::vector<int> stalled;
+    for (int i = 0; i < options.subscribers; i++)
+    {
+        int client;
+        bool stalls = i >= options.subscribers - options.slow;
+        if (!connectPair(listener, address, stalls, subscribers[i].fd, client))
+        {
+            perror("connect");
+            return 1;
+        }
+        (stalls ? stalled : readers).push_back(client);
+    }
+
+    Received received;
+    std::atomic<bool> stop{false};
+    std::thread reader(readAll, readers, std::ref(received), std::ref(stop));
+
+    SseFrame<FRAME_SIZE> frame;
+    char message[SseFrame<FRAME_SIZE>::MESSAGE_SIZE];
+    unsigned long long emitted = 0;
+    unsigned long long frames = 0;
+    unsigned long long sentBytes = 0;
+    int dropped = 0;
+    double droppedAt = 0;
+
+    double cpu = 0;
+    double wallStart = nowSeconds(CLOCK_MONOTONIC);
+    while (nowSeconds(CLOCK_MONOTONIC) - wallStart < options.seconds)
+    {
+        double cpuStart = nowSeconds(CLOCK_THREAD_CPUTIME_ID);
+        for (int e = 0; e < options.eventsPerFrame; e++)
+        {
+            int fields[3];
+            char code;
+            int count = scriptedEvent(emitted, fields, code);
+            if (!frame.append(code, fields, count))
+            {
+                break; // frame full; the rest of this frame is not counted
+            }
+            emitted++;
+        }
+        int length = frame.message(message);
+        for (Subscriber &sub : subscribers)
+        {
+            if (!sub.active)
+            {
+                continue;
+            }
+            SseDrain result = SSE_CLOSED;
+            if (sub.queue.enqueue(message, length))
+            {
+                result = sub.queue.drain([&](const char *data, int n) {
+                    int sent = (int)send(sub.fd, data, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+                    sentBytes += sent > 0 ? sent : 0;
+                    return sent;
+                });
+            }
+            if (result == SSE_CLOSED)
+            {
+                sub.active = false;
+                close(sub.fd);
+                dropped++;
+                droppedAt = nowSeconds(CLOCK_MONOTONIC) - wallStart;
+            }
+        }
+        frames++;
+        cpu += nowSeconds(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+        if (options.frameUs > 0)
+        {
+            usleep(options.frameUs);
+        }
+    }
+    double wall = nowSeconds(CLOCK_MONOTONIC) - wallStart;
+
+    usleep(200000); // let the readers catch up with what is in flight
+    stop = true;
+    reader.join();
+
+    int fast = options.subscribers - options.slow;
+    printf("%d subscribers (%d reading, %d stalled), %d events/frame, %.1f s\n", options.subscribers, fast,
+           options.slow, options.eventsPerFrame, wall);
+    printf("emitted     %10.0f events/s  %10.0f frames/s\n", emitted / wall, frames / wall);
+    printf("delivered   %10.0f events/s  (%.0f per reading subscriber, %.1f MB/s sent)\n",
+           received.events / wall, fast ? received.events / wall / fast : 0.0, sentBytes / wall / 1e6);
+    printf("cpu         %10.1f%% of one core on the emitting loop\n", 100 * cpu / wall);
+    printf("            %10.0f ns per frame, %.0f ns per event, %.0f ns per event per subscriber\n",
+           cpu / frames * 1e9, cpu / emitted * 1e9, cpu / emitted / options.subscribers * 1e9);
+    printf("dropped     %10d subscribers (queue full)%s", dropped, dropped ? "" : "\n");
+    if (dropped)
+    {
+        printf(", last after %.2f s\n", droppedAt);
+    }
+
+    for (int fd : readers)
+    {
+        close(fd);
+    }
+    for (int fd : stalled)
+    {
+        close(fd);
+    }
+    close(listener);
+    return 0;
+}
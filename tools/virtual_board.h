@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "bot_players.h"
+#include "game_flow.h"
+
+// A game_flow.h Board on a virtual millisecond clock, for the host tools:
+// the firmware's own playback, input loop, debounce, timeouts and round
+// pause run unchanged, and a bot (bot_players.h) plays the buttons.
+//
+//     VirtualBoard<Core, ErrorRateBot> board(core, bot, botRng);
+//     playRounds(board, core, score);
+//     board.millis()    // how long the game took
+//
+// While the player's turn waits for input the clock advances in pollMs
+// ticks, never past the bot's press: the cabinet's loop polls faster
+// than 1 ms, so the golden timelines use pollMs = 1, and tools that play
+// millions of games use a coarser tick, which can only move a time-up or
+// abandon by less than a tick. A bot's hold shorter than DEBOUNCE_MS
+// costs nothing extra, as on the cabinet.
+//
+// With a timeline attached, every LED, sound and LCD change, press,
+// release and round boundary is written down with its time.
+
+struct TimelineEvent
+{
+    unsigned long at;
+    std::string text;
+};
+
+template <class Core, class Player>
+class VirtualBoard
+{
+public:
+    struct Scope
+    {
+        Scope(FlowPhase, uint32_t) {}
+    };
+
+    VirtualBoard(const Core &core, Player &player, Pcg32 &rng, unsigned long holdMs = 80, unsigned long pollMs = 1,
+                 std::vector<TimelineEvent> *timeline = nullptr)
+        : core_(core), player_(player), rng_(rng), holdMs_(holdMs), pollMs_(pollMs), timeline_(timeline)
+    {
+    }
+
+    unsigned long millis() { return now_; }
+    void delay(unsigned long ms) { now_ += ms; }
+
+    bool buttonDown(int &button)
+    {
+        if (!inputPhase_)
+        {
+            now_ += pollMs_;
+            return false;
+        }
+        if (!decided_)
+        {
+            unsigned long reactionMs;
+            button_ = player_.press(step_, core_.expected(step_), rng_, reactionMs);
+            pressAt_ = promptedAt_ + reactionMs;
+            decided_ = true;
+        }
+        if (button_ == NO_PRESS || now_ < pressAt_)
+        {
+            unsigned long next = now_ + pollMs_;
+            now_ = button_ != NO_PRESS && next > pressAt_ ? pressAt_ : next;
+            return false;
+        }
+        button = button_;
+        heldUntil_ = now_ + holdMs_;
+        decided_ = false;
+        step_++;
+        presses_++;
+        record("PRESS %d", button);
+        return true;
+    }
+
+    bool buttonHeld(int button)
+    {
+        if (now_ < heldUntil_)
+        {
+            now_ += pollMs_;
+            return true;
+        }
+        if (heldUntil_)
+        {
+            heldUntil_ = 0;
+            record("RELEASE %d", button);
+        }
+        return false;
+    }
+
+    void led(int button, bool on)
+    {
+        record("LED %d %s", button, on ? "on" : "off");
+        if (!on && inputPhase_)
+        {
+            promptedAt_ = now_; // feedback done, next step may be pressed
+        }
+    }
+
+    void sound(int button) { record("SOUND %d", button + 1); }
+
+    void showScore(const char *line2)
+    {
+        record("LCD %s", line2);
+        inputPhase_ = strcmp(line2, "Your Turn") == 0;
+        if (inputPhase_)
+        {
+            promptedAt_ = now_;
+            step_ = 0;
+            decided_ = false;
+        }
+    }
+
+    void lcd(const char *line1, const char *line2) { record("LCD %s|%s", line1, line2); }
+    void background() {}
+
+    template <class AnyCore>
+    void onRoundStart(const AnyCore &core, int added)
+    {
+        round_++;
+        record("ROUND %d length %u (+%d) step %lu gap %lu feedback %lu", round_, (unsigned)core.length(), added,
+               core.tempo().stepMs, core.tempo().gapMs, core.tempo().feedbackMs);
+        player_.onRoundStart(core, added);
+    }
+
+    void onStep(size_t, uint8_t) {}
+    void onPress(int button, unsigned long reactionMs, bool correct) { player_.onPress(button, reactionMs, correct); }
+
+    void onRoundCleared(int score)
+    {
+        record("SCORE %d", score);
+        player_.onRoundCleared(score);
+    }
+
+    void onGameEnd(GameEnd why)
+    {
+        static const char *const NAMES[] = {"wrong-press", "time-up", "abandoned", "marathon"};
+        record("END %s", NAMES[why]);
+        player_.onGameEnd(why);
+    }
+
+    unsigned long presses() const { return presses_; }
+    int rounds() const { return round_; }
+
+private:
+    template <class... Args>
+    void record(const char *format, Args... args)
+    {
+        if (!timeline_)
+        {
+            return;
+        }
+        char text[128];
+        snprintf(text, sizeof(text), format, args...);
+        timeline_->push_back({now_, text});
+    }
+
+    const Core &core_;
+    Player &player_;
+    Pcg32 &rng_;
+    unsigned long holdMs_;
+    unsigned long pollMs_;
+    std::vector<TimelineEvent> *timeline_;
+
+    unsigned long now_ = 0;
+    unsigned long promptedAt_ = 0;
+    unsigned long pressAt_ = 0;
+    unsigned long heldUntil_ = 0;
+    bool inputPhase_ = false;
+    bool decided_ = false;
+    uint8_t button_ = 0;
+    size_t step_ = 0;
+    unsigned long presses_ = 0;
+    int round_ = 0;
+};
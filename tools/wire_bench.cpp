@@ -0,0 +1,139 @@
+// Host benchmark: JSON vs MessagePack for the messages the device
+// exchanges (score upload, login, volume and the replies to them), as
+// encoded size and encode/decode time.
+//
+// Builds against the ArduinoJson copy PlatformIO fetched for the firmware,
+// so both formats go through the same library code the device runs:
+//     pio run    # once, to populate .pio/libdeps
+//     g++ -O2 -std=c++17 -Iinclude -I.pio/libdeps/esp32dev/ArduinoJson/src tools/wire_bench.cpp -o wire_bench
+//     ./wire_bench
+//
+// Documents live in a BumpArena reset after every message, as
+// RequestScope does on the device, so allocation is the arena's and not
+// the host malloc's. Host times are only good for comparing the two
+// formats with each other; sizes are exactly what goes over the air.
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <stdio.h>
+
+#include "bump_arena.h"
+
+namespace
+{
+    const size_t ARENA_SIZE = 4096; // REQUEST_ARENA_SIZE in request_arena.h
+    const size_t BODY_SIZE = 512;   // WIRE_MAX_BODY in wire_codec.h
+
+    alignas(max_align_t) uint8_t memory[ARENA_SIZE];
+    BumpArena arena(memory, sizeof(memory));
+
+    class ArenaJsonAllocator : public ArduinoJson::Allocator
+    {
+    public:
+        void *allocate(size_t size) override { return arena.allocate(size); }
+        void deallocate(void *) override {}
+        void *reallocate(void *ptr, size_t size) override { return arena.reallocate(ptr, size); }
+    };
+    ArenaJsonAllocator allocator;
+
+    // The fields submitScore(), the web app's /esp-login and /set-volume
+    // and the handlers' replies carry.
+    void fillScore(JsonDocument &doc)
+    {
+        doc["user_id"] = 42017;
+        doc["score"] = 1230;
+        doc["seed"] = 2654435769u;
+        doc["mode"] = 2;
+        doc["gen"] = 1;
+        doc["device_id"] = "24A1600B1C2D";
+    }
+
+    void fillLogin(JsonDocument &doc)
+    {
+        doc["user_id"] = 42017;
+        doc["username"] = "daniel";
+        doc["volume"] = 20;
+        doc["sound"] = 3;
+    }
+
+    void fillVolume(JsonDocument &doc)
+    {
+        doc["volume"] = 20;
+    }
+
+    void fillQueued(JsonDocument &doc)
+    {
+        doc["message"] = "Queued";
+        doc["position"] = 2;
+    }
+
+    struct Message
+    {
+        const char *name;
+        void (*fill)(JsonDocument &);
+    };
+
+    const Message MESSAGES[] = {
+        {"submit-score", fillScore},
+        {"esp-login", fillLogin},
+        {"set-volume", fillVolume},
+        {"queued-reply", fillQueued},
+    };
+
+    template <class Run>
+    double nanosPerMessage(Run run, int iterations)
+    {
+        auto startedAt = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            run();
+            arena.reset();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - startedAt;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+
+    size_t encode(const Message &message, uint8_t *out, bool msgpack)
+    {
+        JsonDocument doc(&allocator);
+        message.fill(doc);
+        return msgpack ? serializeMsgPack(doc, out, BODY_SIZE) : serializeJson(doc, (char *)out, BODY_SIZE);
+    }
+
+    bool decode(const uint8_t *body, size_t length, bool msgpack)
+    {
+        JsonDocument doc(&allocator);
+        DeserializationError error = msgpack ? deserializeMsgPack(doc, body, length)
+                                             : deserializeJson(doc, (const char *)body, length);
+        return !error && doc.size() > 0;
+    }
+}
+
+int main()
+{
+    const int iterations = 500000;
+    volatile size_t sink = 0;
+
+    printf("%-14s %6s %6s %12s %12s %12s %12s\n", "message", "json B", "mp B", "json enc ns", "mp enc ns",
+           "json dec ns", "mp dec ns");
+    for (const Message &message : MESSAGES)
+    {
+        uint8_t json[BODY_SIZE];
+        uint8_t msgpack[BODY_SIZE];
+        size_t jsonLength = encode(message, json, false);
+        size_t msgpackLength = encode(message, msgpack, true);
+        arena.reset();
+
+        double jsonEncodeNs = nanosPerMessage([&]() { sink = sink + encode(message, json, false); }, iterations);
+        double msgpackEncodeNs = nanosPerMessage([&]() { sink = sink + encode(message, msgpack, true); }, iterations);
+        double jsonDecodeNs = nanosPerMessage([&]() { sink = sink + decode(json, jsonLength, false); }, iterations);
+        double msgpackDecodeNs =
+            nanosPerMessage([&]() { sink = sink + decode(msgpack, msgpackLength, true); }, iterations);
+
+        printf("%-14s %6zu %6zu %12.1f %12.1f %12.1f %12.1f\n", message.name, jsonLength, msgpackLength,
+               jsonEncodeNs, msgpackEncodeNs, jsonDecodeNs, msgpackDecodeNs);
+    }
+    printf("\narena peak %zu of %zu bytes, %u failed allocations\n", arena.peak(), ARENA_SIZE, arena.failures());
+    (void)sink;
+    return 0;
+}